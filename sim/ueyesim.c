@@ -0,0 +1,1493 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ *
+ * Author P Barber
+ */
+// A simulated uEye camera, standing in for libueye_api so that the plugin can run without a camera
+// (configure --enable-simulator). Only the calls the plugin makes are implemented, with the behaviour
+// the plugin relies on: an image memory sequence filled in turn, an image queue that locks each
+// buffer until it is unlocked, device timestamps and frame numbers, and the capture status count.
+//
+// A thread per open camera produces frames at the frame rate, a software trigger or is_FreezeVideo
+// produces one after the exposure time, hardware trigger modes fire at the frame rate as if a
+// generator were attached. Each row of a frame is filled with one value that moves with the frame number.
+//
+// Set up with environment variables, read when the first camera call is made:
+//   UEYE_SIM_CAMERAS     number of cameras, default 1
+//   UEYE_SIM_WIDTH       sensor width, default 1280
+//   UEYE_SIM_HEIGHT      sensor height, default 1024
+//   UEYE_SIM_SENSOR      bayer or mono, default bayer
+//   UEYE_SIM_MAX_FPS     fastest frame rate, default 100
+//   UEYE_SIM_JITTER_US   each frame is up to this early or late, default 0
+//   UEYE_SIM_DROP        probability that a frame is lost in transfer, 0 to 1, default 0
+//   UEYE_SIM_DRIFT_PPM   device clock runs fast (or slow if negative) by this, default 0
+//   UEYE_SIM_HW_LUT      1 if the camera has a hardware LUT, default 0
+//   UEYE_SIM_INIT_MS     is_InitCamera takes this long, as a USB camera's bring-up does, default 0
+//   UEYE_SIM_UNPLUG_AFTER an open camera is unplugged after this many frames, 0 (default) never
+//   UEYE_SIM_UNPLUG_MS   and comes back this much later, default 2000
+//   UEYE_SIM_MAX_BITS    deepest sensor mode, 8, 10 or 12, default 12
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include  <ueye.h>
+
+#define SIM_MAX_CAMERAS 8
+#define SIM_MAX_BUFFERS 256
+#define SIM_AOI_WIDTH_INC 8
+#define SIM_AOI_HEIGHT_INC 2
+#define SIM_AOI_POS_INC 2
+#define SIM_AOI_MIN_WIDTH 32
+#define SIM_AOI_MIN_HEIGHT 4
+
+#ifndef IS_GET_BINNING
+#define IS_GET_BINNING 0x8000
+#endif
+#ifndef IS_GET_SUBSAMPLING
+#define IS_GET_SUBSAMPLING 0x8000
+#endif
+#ifndef IS_CM_PREFER_PACKED_SOURCE_FORMAT
+#define IS_CM_PREFER_PACKED_SOURCE_FORMAT 0x4000
+#endif
+#ifndef IS_GET_FRAMERATE
+#define IS_GET_FRAMERATE 0x8000
+#endif
+
+typedef struct
+{
+	char *pcMem;
+	INT nId;
+	INT nWidth;
+	INT nHeight;
+	INT nBits;
+	INT nPitch;
+	gboolean in_sequence;
+	gboolean locked;  // filled and not yet unlocked, or being filled
+	UEYEIMAGEINFO info;
+} SimBuffer;
+
+typedef struct
+{
+	DWORD dwDeviceID;
+	gchar serial[16];
+	gboolean open;
+	gboolean removed;  // unplugged while open, until is_ExitCamera
+	gboolean remove_signalled;
+	gint64 gone_until;  // monotonic time an unplugged camera comes back
+
+	// settings
+	INT nColorMode;
+	INT nBitsPerPixel;
+	IS_RECT aoi;
+	INT binning;
+	INT subsampling;
+	UINT pixelclock;
+	double exposure;  // ms
+	double fps;
+	INT gain, rgain, ggain, bgain;
+	INT blacklevel;
+	INT gamma;
+	INT trigger;
+	INT rop;
+	INT last_error;
+
+	// image memory, queue and capture
+	SimBuffer buffers[SIM_MAX_BUFFERS];
+	INT nBuffers;
+	INT next_id;
+	INT next_fill;  // next buffer of the sequence to fill
+	gboolean image_queue;
+	INT queue[SIM_MAX_BUFFERS];  // indices of filled buffers, oldest first
+	INT queue_head;
+	INT queue_count;
+	gboolean live;
+	gboolean filling;
+	gint triggers;  // frames asked for by software trigger or is_FreezeVideo
+	guint64 frame_number;
+	DWORD capture_failures;
+	gint64 t0;  // monotonic time the device clock started
+
+	GThread *thread;
+	gboolean stop;
+	GMutex lock;
+	GCond cond;
+} SimCamera;
+
+static struct
+{
+	gint cameras;
+	gint width;
+	gint height;
+	gboolean mono;
+	gdouble max_fps;
+	gint jitter_us;
+	gdouble drop;
+	gdouble drift_ppm;
+	gboolean hw_lut;
+	gint init_ms;
+	gint unplug_after;
+	gint unplug_ms;
+	gint max_bits;
+} sim_config;
+
+static SimCamera sim_cameras[SIM_MAX_CAMERAS];
+static GMutex sim_lock;  // taken around testing and claiming a camera's open flag, before any camera's lock
+
+static gint
+sim_getenv_int (const gchar * name, gint def)
+{
+	const gchar *value = g_getenv (name);
+
+	return value != NULL ? atoi (value) : def;
+}
+
+static gdouble
+sim_getenv_double (const gchar * name, gdouble def)
+{
+	const gchar *value = g_getenv (name);
+
+	return value != NULL ? g_ascii_strtod (value, NULL) : def;
+}
+
+static void
+sim_init (void)
+{
+	static gsize initialised = 0;
+	gint i;
+
+	if (!g_once_init_enter (&initialised))
+		return;
+
+	sim_config.cameras = CLAMP (sim_getenv_int ("UEYE_SIM_CAMERAS", 1), 0, SIM_MAX_CAMERAS);
+	sim_config.width = MAX (sim_getenv_int ("UEYE_SIM_WIDTH", 1280), SIM_AOI_MIN_WIDTH) / SIM_AOI_WIDTH_INC * SIM_AOI_WIDTH_INC;
+	sim_config.height = MAX (sim_getenv_int ("UEYE_SIM_HEIGHT", 1024), SIM_AOI_MIN_HEIGHT) / SIM_AOI_HEIGHT_INC * SIM_AOI_HEIGHT_INC;
+	sim_config.mono = g_strcmp0 (g_getenv ("UEYE_SIM_SENSOR"), "mono") == 0;
+	sim_config.max_fps = MAX (sim_getenv_double ("UEYE_SIM_MAX_FPS", 100.0), 1.0);
+	sim_config.jitter_us = MAX (sim_getenv_int ("UEYE_SIM_JITTER_US", 0), 0);
+	sim_config.drop = CLAMP (sim_getenv_double ("UEYE_SIM_DROP", 0.0), 0.0, 1.0);
+	sim_config.drift_ppm = sim_getenv_double ("UEYE_SIM_DRIFT_PPM", 0.0);
+	sim_config.hw_lut = sim_getenv_int ("UEYE_SIM_HW_LUT", 0) != 0;
+	sim_config.init_ms = MAX (sim_getenv_int ("UEYE_SIM_INIT_MS", 0), 0);
+	sim_config.unplug_after = MAX (sim_getenv_int ("UEYE_SIM_UNPLUG_AFTER", 0), 0);
+	sim_config.unplug_ms = MAX (sim_getenv_int ("UEYE_SIM_UNPLUG_MS", 2000), 0);
+	sim_config.max_bits = CLAMP (sim_getenv_int ("UEYE_SIM_MAX_BITS", 12), 8, 12);
+
+	for (i = 0; i < SIM_MAX_CAMERAS; i++) {
+		sim_cameras[i].dwDeviceID = i + 1;
+		g_snprintf (sim_cameras[i].serial, sizeof (sim_cameras[i].serial), "41%08d", i + 1);
+		g_mutex_init (&sim_cameras[i].lock);
+		g_cond_init (&sim_cameras[i].cond);
+	}
+
+	g_once_init_leave (&initialised, 1);
+}
+
+// Not unplugged, or back again
+static gboolean
+sim_present (SimCamera * cam)
+{
+	return g_get_monotonic_time () >= cam->gone_until;
+}
+
+// Handles are device ids
+static SimCamera *
+sim_get_camera (HIDS hCam)
+{
+	sim_init ();
+	if (hCam < 1 || hCam > (HIDS) sim_config.cameras || !sim_cameras[hCam - 1].open)
+		return NULL;
+
+	return &sim_cameras[hCam - 1];
+}
+
+// Significant bits of each sample, 10 and 12 bit samples are in the low bits of 16, 16 bit ones fill them
+static gint
+sim_sample_bits (INT mode)
+{
+	switch (mode & ~IS_CM_PREFER_PACKED_SOURCE_FORMAT) {
+	case IS_CM_MONO10:
+	case IS_CM_SENSOR_RAW10:
+		return 10;
+	case IS_CM_MONO12:
+	case IS_CM_SENSOR_RAW12:
+		return 12;
+	case IS_CM_MONO16:
+	case IS_CM_SENSOR_RAW16:
+		return 16;
+	default:
+		return 8;
+	}
+}
+
+static INT
+sim_bits_per_pixel (INT mode)
+{
+	switch (mode & ~IS_CM_PREFER_PACKED_SOURCE_FORMAT) {
+	case IS_CM_MONO8:
+	case IS_CM_SENSOR_RAW8:
+		return 8;
+	case IS_CM_MONO10:
+	case IS_CM_MONO12:
+	case IS_CM_MONO16:
+	case IS_CM_SENSOR_RAW10:
+	case IS_CM_SENSOR_RAW12:
+	case IS_CM_SENSOR_RAW16:
+	case IS_CM_UYVY_PACKED:
+		return 16;
+	case IS_CM_BGR8_PACKED:
+	case IS_CM_RGB8_PACKED:
+		return 24;
+	case IS_CM_BGRA8_PACKED:
+	case IS_CM_RGBA8_PACKED:
+		return 32;
+	default:
+		return 0;
+	}
+}
+
+// How many sensor pixels make one image pixel across or down, binned and subsampled
+static gint
+sim_binning_factor (SimCamera * cam, gboolean horizontal)
+{
+	gint binning, subsampling;
+
+	if (horizontal) {
+		binning = (cam->binning & IS_BINNING_4X_HORIZONTAL) ? 4 : (cam->binning & IS_BINNING_2X_HORIZONTAL) ? 2 : 1;
+		subsampling = (cam->subsampling & IS_SUBSAMPLING_4X_HORIZONTAL) ? 4 : (cam->subsampling & IS_SUBSAMPLING_2X_HORIZONTAL) ? 2 : 1;
+	}
+	else {
+		binning = (cam->binning & IS_BINNING_4X_VERTICAL) ? 4 : (cam->binning & IS_BINNING_2X_VERTICAL) ? 2 : 1;
+		subsampling = (cam->subsampling & IS_SUBSAMPLING_4X_VERTICAL) ? 4 : (cam->subsampling & IS_SUBSAMPLING_2X_VERTICAL) ? 2 : 1;
+	}
+
+	return binning * subsampling;
+}
+
+// The window shrinks to fit when the binning or subsampling changes
+static void
+sim_reset_aoi (SimCamera * cam)
+{
+	cam->aoi.s32X = 0;
+	cam->aoi.s32Y = 0;
+	cam->aoi.s32Width = sim_config.width / sim_binning_factor (cam, TRUE) / SIM_AOI_WIDTH_INC * SIM_AOI_WIDTH_INC;
+	cam->aoi.s32Height = sim_config.height / sim_binning_factor (cam, FALSE) / SIM_AOI_HEIGHT_INC * SIM_AOI_HEIGHT_INC;
+}
+
+static void
+sim_camera_reset (SimCamera * cam)
+{
+	cam->nColorMode = sim_config.mono ? IS_CM_MONO8 : IS_CM_BGR8_PACKED;
+	cam->nBitsPerPixel = sim_bits_per_pixel (cam->nColorMode);
+	cam->binning = IS_BINNING_DISABLE;
+	cam->subsampling = IS_SUBSAMPLING_DISABLE;
+	cam->aoi.s32X = 0;
+	cam->aoi.s32Y = 0;
+	cam->aoi.s32Width = sim_config.width;
+	cam->aoi.s32Height = sim_config.height;
+	cam->pixelclock = 30;
+	cam->fps = MIN (25.0, sim_config.max_fps);
+	cam->exposure = 1000.0 / cam->fps;
+	cam->gain = 0;
+	cam->rgain = cam->ggain = cam->bgain = 0;
+	cam->blacklevel = 0;
+	cam->gamma = 100;
+	cam->trigger = IS_SET_TRIGGER_OFF;
+	cam->rop = 0;
+	cam->last_error = IS_SUCCESS;
+	cam->nBuffers = 0;
+	cam->next_id = 0;
+	cam->next_fill = 0;
+	cam->image_queue = FALSE;
+	cam->queue_head = 0;
+	cam->queue_count = 0;
+	cam->live = FALSE;
+	cam->filling = FALSE;
+	cam->triggers = 0;
+	cam->frame_number = 0;
+	cam->capture_failures = 0;
+	cam->t0 = g_get_monotonic_time ();
+	cam->stop = FALSE;
+	cam->removed = FALSE;
+	cam->remove_signalled = FALSE;
+}
+
+// The next buffer of the sequence that is free to fill, or -1 if they are all locked
+static gint
+sim_next_free_buffer (SimCamera * cam)
+{
+	gint i;
+
+	for (i = 0; i < cam->nBuffers; i++) {
+		gint index = (cam->next_fill + i) % cam->nBuffers;
+
+		if (cam->buffers[index].in_sequence && !cam->buffers[index].locked) {
+			cam->next_fill = (index + 1) % cam->nBuffers;
+			return index;
+		}
+	}
+
+	return -1;
+}
+
+// Called with the lock, which is dropped while the frame is drawn
+static void
+sim_capture_frame (SimCamera * cam, gint64 now)
+{
+	SimBuffer *buf;
+	GDateTime *dt;
+	gint index, x, y, sample_bits;
+	guint8 value;
+
+	cam->frame_number++;
+
+	// unplugged, nothing more comes from it
+	if (sim_config.unplug_after > 0 && cam->frame_number >= (guint64) sim_config.unplug_after) {
+		cam->removed = TRUE;
+		cam->live = FALSE;
+		cam->triggers = 0;
+		cam->gone_until = g_get_monotonic_time () + (gint64) sim_config.unplug_ms * 1000;
+		g_cond_broadcast (&cam->cond);
+		return;
+	}
+
+	// lost in transfer, the frame number moves on
+	if (sim_config.drop > 0.0 && g_random_double () < sim_config.drop) {
+		cam->capture_failures++;
+		return;
+	}
+
+	index = sim_next_free_buffer (cam);
+	if (index < 0) {
+		// every buffer is locked by the application
+		cam->capture_failures++;
+		return;
+	}
+
+	buf = &cam->buffers[index];
+	buf->locked = TRUE;
+	cam->filling = TRUE;
+	sample_bits = buf->nBits == 16 ? sim_sample_bits (cam->nColorMode) : 8;
+	g_mutex_unlock (&cam->lock);
+
+	value = (guint8) (cam->frame_number * 4);
+	for (y = 0; y < buf->nHeight; y++) {
+		if (sample_bits > 8) {
+			guint16 *row = (guint16 *) (buf->pcMem + (gsize) y * buf->nPitch);
+
+			for (x = 0; x < buf->nWidth; x++)
+				row[x] = GUINT16_TO_LE ((guint8) (value + y) << (sample_bits - 8));
+		}
+		else
+			memset (buf->pcMem + (gsize) y * buf->nPitch, (guint8) (value + y), (buf->nWidth * buf->nBits + 7) / 8);
+	}
+
+	memset (&buf->info, 0, sizeof (buf->info));
+	buf->info.u64FrameNumber = cam->frame_number;
+	// 0.1 us ticks
+	buf->info.u64TimestampDevice = (UINT64) ((now - cam->t0) * 10.0 * (1.0 + sim_config.drift_ppm / 1e6));
+	buf->info.dwImageWidth = buf->nWidth;
+	buf->info.dwImageHeight = buf->nHeight;
+	buf->info.dwImageBuffers = cam->nBuffers;
+	dt = g_date_time_new_now_local ();
+	buf->info.TimestampSystem.wYear = g_date_time_get_year (dt);
+	buf->info.TimestampSystem.wMonth = g_date_time_get_month (dt);
+	buf->info.TimestampSystem.wDay = g_date_time_get_day_of_month (dt);
+	buf->info.TimestampSystem.wHour = g_date_time_get_hour (dt);
+	buf->info.TimestampSystem.wMinute = g_date_time_get_minute (dt);
+	buf->info.TimestampSystem.wSecond = g_date_time_get_second (dt);
+	buf->info.TimestampSystem.wMilliseconds = g_date_time_get_microsecond (dt) / 1000;
+	g_date_time_unref (dt);
+
+	g_mutex_lock (&cam->lock);
+	cam->filling = FALSE;
+	if (cam->image_queue && cam->queue_count < SIM_MAX_BUFFERS) {
+		cam->queue[(cam->queue_head + cam->queue_count) % SIM_MAX_BUFFERS] = index;
+		cam->queue_count++;
+	}
+	else {
+		buf->locked = FALSE;
+	}
+	g_cond_broadcast (&cam->cond);
+}
+
+static gpointer
+sim_camera_thread (gpointer data)
+{
+	SimCamera *cam = (SimCamera *) data;
+	gint64 next = 0;
+
+	g_mutex_lock (&cam->lock);
+	while (!cam->stop) {
+		gboolean freerun = cam->live && !cam->removed && cam->trigger != IS_SET_TRIGGER_SOFTWARE;
+		gint64 now = g_get_monotonic_time (), due;
+
+		if (!freerun && (cam->triggers == 0 || cam->removed)) {
+			next = 0;
+			g_cond_wait (&cam->cond, &cam->lock);
+			continue;
+		}
+
+		if (freerun) {
+			gint64 period = (gint64) (G_USEC_PER_SEC / cam->fps);
+
+			// the schedule does not drift with the jitter
+			if (next == 0 || next < now - period)
+				next = now + period;
+			due = next;
+			if (sim_config.jitter_us > 0)
+				due += g_random_int_range (-sim_config.jitter_us, sim_config.jitter_us + 1);
+		}
+		else {
+			due = now + (gint64) (cam->exposure * 1000.0);
+		}
+
+		while (!cam->stop && g_get_monotonic_time () < due)
+			g_cond_wait_until (&cam->cond, &cam->lock, due);
+		if (cam->stop)
+			break;
+
+		if (freerun) {
+			next += (gint64) (G_USEC_PER_SEC / cam->fps);
+			if (!cam->live)
+				continue;
+		}
+		else {
+			if (cam->triggers == 0)
+				continue;
+			cam->triggers--;
+		}
+
+		sim_capture_frame (cam, due);
+	}
+	g_mutex_unlock (&cam->lock);
+
+	return NULL;
+}
+
+INT
+is_GetDLLVersion (void)
+{
+	return (4 << 24) | (40 << 16) | 0;
+}
+
+INT
+is_GetNumberOfCameras (INT * pnNumCams)
+{
+	gint i;
+
+	sim_init ();
+	*pnNumCams = 0;
+	for (i = 0; i < sim_config.cameras; i++)
+		*pnNumCams += sim_present (&sim_cameras[i]);
+
+	return IS_SUCCESS;
+}
+
+INT
+is_GetCameraList (PUEYE_CAMERA_LIST pucl)
+{
+	ULONG n = 0;
+	gint i;
+
+	sim_init ();
+	g_mutex_lock (&sim_lock);
+	for (i = 0; i < sim_config.cameras && n < pucl->dwCount; i++) {
+		UEYE_CAMERA_INFO *info = &pucl->uci[n];
+
+		if (!sim_present (&sim_cameras[i]))
+			continue;
+		n++;
+		memset (info, 0, sizeof (*info));
+		info->dwCameraID = i + 1;
+		info->dwDeviceID = sim_cameras[i].dwDeviceID;
+		info->dwInUse = sim_cameras[i].open;
+		strncpy (info->SerNo, sim_cameras[i].serial, sizeof (info->SerNo));
+		strncpy (info->Model, "UI-SIM", sizeof (info->Model));
+		strncpy (info->FullModelName, "UI-SIM simulated camera", sizeof (info->FullModelName));
+	}
+	g_mutex_unlock (&sim_lock);
+	pucl->dwCount = n;
+
+	return IS_SUCCESS;
+}
+
+INT
+is_InitCamera (HIDS * phCam, HWND hWnd)
+{
+	DWORD id = *phCam;
+	SimCamera *cam = NULL;
+	gint i;
+	INT nRet = IS_SUCCESS;
+
+	sim_init ();
+
+	// the camera is found and claimed in one step, so cameras opened from several threads each take their own
+	g_mutex_lock (&sim_lock);
+	if (id & IS_USE_DEVICE_ID) {
+		id &= ~IS_USE_DEVICE_ID;
+		if (id < 1 || id > (DWORD) sim_config.cameras || !sim_present (&sim_cameras[id - 1]))
+			nRet = IS_CANT_OPEN_DEVICE;
+		else if (sim_cameras[id - 1].open)
+			nRet = IS_ALL_DEVICES_BUSY;
+		else
+			cam = &sim_cameras[id - 1];
+	}
+	else if (id == 0) {
+		for (i = 0; i < sim_config.cameras && cam == NULL; i++)
+			if (!sim_cameras[i].open && sim_present (&sim_cameras[i]))
+				cam = &sim_cameras[i];
+		if (cam == NULL)
+			nRet = sim_config.cameras > 0 ? IS_ALL_DEVICES_BUSY : IS_CANT_OPEN_DEVICE;
+	}
+	else {
+		// camera ids are the same as device ids
+		if (id > (DWORD) sim_config.cameras || !sim_present (&sim_cameras[id - 1]))
+			nRet = IS_CANT_OPEN_DEVICE;
+		else if (sim_cameras[id - 1].open)
+			nRet = IS_ALL_DEVICES_BUSY;
+		else
+			cam = &sim_cameras[id - 1];
+	}
+
+	if (cam != NULL) {
+		g_mutex_lock (&cam->lock);
+		sim_camera_reset (cam);
+		cam->open = TRUE;
+		g_mutex_unlock (&cam->lock);
+	}
+	g_mutex_unlock (&sim_lock);
+	if (cam == NULL)
+		return nRet;
+
+	if (sim_config.init_ms > 0)
+		g_usleep (sim_config.init_ms * 1000);
+	cam->thread = g_thread_new ("ueyesim", sim_camera_thread, cam);
+	*phCam = cam->dwDeviceID;
+
+	return IS_SUCCESS;
+}
+
+INT
+is_ExitCamera (HIDS hCam)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	g_mutex_lock (&cam->lock);
+	cam->stop = TRUE;
+	cam->live = FALSE;
+	g_cond_broadcast (&cam->cond);
+	g_mutex_unlock (&cam->lock);
+	g_thread_join (cam->thread);
+	cam->thread = NULL;
+
+	g_mutex_lock (&sim_lock);
+	g_mutex_lock (&cam->lock);
+	cam->open = FALSE;
+	cam->nBuffers = 0;
+	cam->queue_count = 0;
+	g_mutex_unlock (&cam->lock);
+	g_mutex_unlock (&sim_lock);
+
+	return IS_SUCCESS;
+}
+
+INT
+is_GetError (HIDS hCam, INT * pErr, IS_CHAR ** ppcErr)
+{
+	static IS_CHAR message[64];
+	SimCamera *cam = sim_get_camera (hCam);
+	INT err = cam != NULL ? cam->last_error : IS_INVALID_CAMERA_HANDLE;
+
+	g_snprintf (message, sizeof (message), "simulated camera error %d", err);
+	if (pErr != NULL)
+		*pErr = err;
+	if (ppcErr != NULL)
+		*ppcErr = message;
+
+	return IS_SUCCESS;
+}
+
+INT
+is_GetCameraInfo (HIDS hCam, PCAMINFO pInfo)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	memset (pInfo, 0, sizeof (*pInfo));
+	strncpy (pInfo->SerNo, cam->serial, sizeof (pInfo->SerNo));
+	strncpy (pInfo->ID, "IDS GmbH", sizeof (pInfo->ID));
+	strncpy (pInfo->Version, "V1.00", sizeof (pInfo->Version));
+
+	return IS_SUCCESS;
+}
+
+INT
+is_GetSensorInfo (HIDS hCam, PSENSORINFO pInfo)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	memset (pInfo, 0, sizeof (*pInfo));
+	g_snprintf (pInfo->strSensorName, sizeof (pInfo->strSensorName), "SIM%dx%d%s",
+			sim_config.width, sim_config.height, sim_config.mono ? "M" : "C");
+	pInfo->nColorMode = sim_config.mono ? IS_COLORMODE_MONOCHROME : IS_COLORMODE_BAYER;
+	pInfo->nMaxWidth = sim_config.width;
+	pInfo->nMaxHeight = sim_config.height;
+	pInfo->bMasterGain = TRUE;
+	pInfo->bRGain = pInfo->bGGain = pInfo->bBGain = !sim_config.mono;
+	pInfo->bGlobShutter = TRUE;
+	pInfo->wPixelSize = 530;
+	pInfo->nUpperLeftBayerPixel = BAYER_PIXEL_RED;
+
+	return IS_SUCCESS;
+}
+
+INT
+is_SetAllocatedImageMem (HIDS hCam, INT width, INT height, INT bitspixel, char *pcImgMem, INT * pid)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+	SimBuffer *buf;
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+	if (pcImgMem == NULL || width < 1 || height < 1 || bitspixel < 1)
+		return IS_INVALID_PARAMETER;
+
+	g_mutex_lock (&cam->lock);
+	if (cam->nBuffers >= SIM_MAX_BUFFERS) {
+		g_mutex_unlock (&cam->lock);
+		return IS_NO_SUCCESS;
+	}
+	buf = &cam->buffers[cam->nBuffers++];
+	memset (buf, 0, sizeof (*buf));
+	buf->pcMem = pcImgMem;
+	buf->nId = ++cam->next_id;
+	buf->nWidth = width;
+	buf->nHeight = height;
+	buf->nBits = bitspixel;
+	buf->nPitch = ((width * bitspixel + 7) / 8 + 3) & ~3;
+	*pid = buf->nId;
+	g_mutex_unlock (&cam->lock);
+
+	return IS_SUCCESS;
+}
+
+static SimBuffer *
+sim_find_buffer (SimCamera * cam, char *pcMem, INT nId)
+{
+	gint i;
+
+	for (i = 0; i < cam->nBuffers; i++) {
+		if ((nId > 0 && cam->buffers[i].nId == nId) || (nId <= 0 && cam->buffers[i].pcMem == pcMem))
+			return &cam->buffers[i];
+	}
+
+	return NULL;
+}
+
+INT
+is_FreeImageMem (HIDS hCam, char *pcImgMem, INT id)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+	SimBuffer *buf;
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	g_mutex_lock (&cam->lock);
+	while (cam->filling)
+		g_cond_wait (&cam->cond, &cam->lock);
+	buf = sim_find_buffer (cam, pcImgMem, id);
+	if (buf != NULL) {
+		*buf = cam->buffers[--cam->nBuffers];
+		cam->next_fill = 0;
+	}
+	g_mutex_unlock (&cam->lock);
+
+	return buf != NULL ? IS_SUCCESS : IS_INVALID_PARAMETER;
+}
+
+INT
+is_InquireImageMem (HIDS hCam, char *pcMem, INT nID, INT * pnX, INT * pnY, INT * pnBits, INT * pnPitch)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+	SimBuffer *buf;
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	g_mutex_lock (&cam->lock);
+	buf = sim_find_buffer (cam, pcMem, nID);
+	if (buf != NULL) {
+		if (pnX)
+			*pnX = buf->nWidth;
+		if (pnY)
+			*pnY = buf->nHeight;
+		if (pnBits)
+			*pnBits = buf->nBits;
+		if (pnPitch)
+			*pnPitch = buf->nPitch;
+	}
+	g_mutex_unlock (&cam->lock);
+
+	return buf != NULL ? IS_SUCCESS : IS_INVALID_PARAMETER;
+}
+
+INT
+is_AddToSequence (HIDS hCam, char *pcMem, INT nId)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+	SimBuffer *buf;
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	g_mutex_lock (&cam->lock);
+	buf = sim_find_buffer (cam, pcMem, nId);
+	if (buf != NULL)
+		buf->in_sequence = TRUE;
+	g_mutex_unlock (&cam->lock);
+
+	return buf != NULL ? IS_SUCCESS : IS_INVALID_PARAMETER;
+}
+
+INT
+is_ClearSequence (HIDS hCam)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+	gint i;
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	g_mutex_lock (&cam->lock);
+	while (cam->filling)
+		g_cond_wait (&cam->cond, &cam->lock);
+	for (i = 0; i < cam->nBuffers; i++)
+		cam->buffers[i].in_sequence = FALSE;
+	g_mutex_unlock (&cam->lock);
+
+	return IS_SUCCESS;
+}
+
+INT
+is_UnlockSeqBuf (HIDS hCam, INT nNum, char *pcMem)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+	SimBuffer *buf;
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	g_mutex_lock (&cam->lock);
+	buf = sim_find_buffer (cam, pcMem, nNum);
+	if (buf != NULL)
+		buf->locked = FALSE;
+	g_mutex_unlock (&cam->lock);
+
+	return buf != NULL ? IS_SUCCESS : IS_INVALID_PARAMETER;
+}
+
+INT
+is_InitImageQueue (HIDS hCam, INT nMode)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	g_mutex_lock (&cam->lock);
+	cam->image_queue = TRUE;
+	cam->queue_head = 0;
+	cam->queue_count = 0;
+	g_mutex_unlock (&cam->lock);
+
+	return IS_SUCCESS;
+}
+
+INT
+is_ExitImageQueue (HIDS hCam)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+	gint i;
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	g_mutex_lock (&cam->lock);
+	while (cam->filling)
+		g_cond_wait (&cam->cond, &cam->lock);
+	cam->image_queue = FALSE;
+	cam->queue_count = 0;
+	for (i = 0; i < cam->nBuffers; i++)
+		cam->buffers[i].locked = FALSE;
+	g_mutex_unlock (&cam->lock);
+
+	return IS_SUCCESS;
+}
+
+INT
+is_WaitForNextImage (HIDS hCam, UINT timeout, char **ppcMem, INT * imageID)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+	gint64 end_time;
+	SimBuffer *buf;
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	end_time = g_get_monotonic_time () + (gint64) timeout * G_TIME_SPAN_MILLISECOND;
+	g_mutex_lock (&cam->lock);
+	if (cam->removed) {
+		g_mutex_unlock (&cam->lock);
+		return IS_NO_SUCCESS;
+	}
+	while (cam->queue_count == 0) {
+		if (!cam->image_queue || !g_cond_wait_until (&cam->cond, &cam->lock, end_time)) {
+			g_mutex_unlock (&cam->lock);
+			return IS_TIMED_OUT;
+		}
+	}
+	buf = &cam->buffers[cam->queue[cam->queue_head]];
+	cam->queue_head = (cam->queue_head + 1) % SIM_MAX_BUFFERS;
+	cam->queue_count--;
+	*ppcMem = buf->pcMem;
+	*imageID = buf->nId;
+	g_mutex_unlock (&cam->lock);
+
+	return IS_SUCCESS;
+}
+
+INT
+is_GetImageInfo (HIDS hCam, INT nImageBufferID, UEYEIMAGEINFO * pImageInfo, INT nImageInfoSize)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+	SimBuffer *buf;
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	g_mutex_lock (&cam->lock);
+	buf = sim_find_buffer (cam, NULL, nImageBufferID);
+	if (buf != NULL) {
+		gint i, in_use = 0;
+
+		for (i = 0; i < cam->nBuffers; i++)
+			in_use += cam->buffers[i].locked;
+		buf->info.dwImageBuffersInUse = in_use;
+		memcpy (pImageInfo, &buf->info, MIN ((gsize) nImageInfoSize, sizeof (buf->info)));
+	}
+	g_mutex_unlock (&cam->lock);
+
+	return buf != NULL ? IS_SUCCESS : IS_INVALID_PARAMETER;
+}
+
+INT
+is_CaptureStatus (HIDS hCam, UINT nCommand, void *pParam, UINT cbSizeOfParam)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+	UEYE_CAPTURE_STATUS_INFO *info = (UEYE_CAPTURE_STATUS_INFO *) pParam;
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	g_mutex_lock (&cam->lock);
+	switch (nCommand) {
+	case IS_CAPTURE_STATUS_INFO_CMD_RESET:
+		cam->capture_failures = 0;
+		break;
+	case IS_CAPTURE_STATUS_INFO_CMD_GET:
+		if (info == NULL || cbSizeOfParam < sizeof (*info)) {
+			g_mutex_unlock (&cam->lock);
+			return IS_INVALID_PARAMETER;
+		}
+		memset (info, 0, sizeof (*info));
+		info->dwCapStatusCnt_Total = cam->capture_failures;
+		break;
+	default:
+		g_mutex_unlock (&cam->lock);
+		return IS_NOT_SUPPORTED;
+	}
+	g_mutex_unlock (&cam->lock);
+
+	return IS_SUCCESS;
+}
+
+INT
+is_SetColorMode (HIDS hCam, INT Mode)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+	INT bits;
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+	if (Mode == IS_GET_COLOR_MODE)
+		return cam->nColorMode;
+
+	bits = sim_bits_per_pixel (Mode);
+	if (bits == 0 || (sim_sample_bits (Mode) < 16 && sim_sample_bits (Mode) > sim_config.max_bits))
+		return IS_INVALID_PARAMETER;
+	cam->nColorMode = Mode;
+	cam->nBitsPerPixel = bits;
+
+	return IS_SUCCESS;
+}
+
+INT
+is_AOI (HIDS hCam, UINT nCommand, void *pParam, UINT SizeOfParam)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+	gint max_width, max_height;
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	max_width = sim_config.width / sim_binning_factor (cam, TRUE) / SIM_AOI_WIDTH_INC * SIM_AOI_WIDTH_INC;
+	max_height = sim_config.height / sim_binning_factor (cam, FALSE) / SIM_AOI_HEIGHT_INC * SIM_AOI_HEIGHT_INC;
+
+	switch (nCommand) {
+	case IS_AOI_IMAGE_SET_AOI: {
+		IS_RECT *rect = (IS_RECT *) pParam;
+
+		if (rect->s32Width < SIM_AOI_MIN_WIDTH || rect->s32Height < SIM_AOI_MIN_HEIGHT
+				|| rect->s32Width % SIM_AOI_WIDTH_INC || rect->s32Height % SIM_AOI_HEIGHT_INC
+				|| rect->s32X < 0 || rect->s32Y < 0 || rect->s32X % SIM_AOI_POS_INC || rect->s32Y % SIM_AOI_POS_INC
+				|| rect->s32X + rect->s32Width > max_width || rect->s32Y + rect->s32Height > max_height) {
+			cam->last_error = IS_INVALID_PARAMETER;
+			return IS_INVALID_PARAMETER;
+		}
+		cam->aoi = *rect;
+		break;
+	}
+	case IS_AOI_IMAGE_GET_AOI:
+		*(IS_RECT *) pParam = cam->aoi;
+		break;
+	case IS_AOI_IMAGE_GET_SIZE_MIN:
+		((IS_SIZE_2D *) pParam)->s32Width = SIM_AOI_MIN_WIDTH;
+		((IS_SIZE_2D *) pParam)->s32Height = SIM_AOI_MIN_HEIGHT;
+		break;
+	case IS_AOI_IMAGE_GET_SIZE_MAX:
+		((IS_SIZE_2D *) pParam)->s32Width = max_width;
+		((IS_SIZE_2D *) pParam)->s32Height = max_height;
+		break;
+	case IS_AOI_IMAGE_GET_SIZE_INC:
+		((IS_SIZE_2D *) pParam)->s32Width = SIM_AOI_WIDTH_INC;
+		((IS_SIZE_2D *) pParam)->s32Height = SIM_AOI_HEIGHT_INC;
+		break;
+	case IS_AOI_IMAGE_GET_POS_MIN:
+		((IS_POINT_2D *) pParam)->s32X = 0;
+		((IS_POINT_2D *) pParam)->s32Y = 0;
+		break;
+	case IS_AOI_IMAGE_GET_POS_INC:
+		((IS_POINT_2D *) pParam)->s32X = SIM_AOI_POS_INC;
+		((IS_POINT_2D *) pParam)->s32Y = SIM_AOI_POS_INC;
+		break;
+	default:
+		return IS_NOT_SUPPORTED;
+	}
+
+	return IS_SUCCESS;
+}
+
+INT
+is_SetBinning (HIDS hCam, INT mode)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+	if (mode == IS_GET_BINNING)
+		return cam->binning;
+	if (mode == IS_GET_SUPPORTED_BINNING)
+		return IS_BINNING_2X_VERTICAL | IS_BINNING_2X_HORIZONTAL | IS_BINNING_4X_VERTICAL | IS_BINNING_4X_HORIZONTAL;
+
+	cam->binning = mode;
+	sim_reset_aoi (cam);
+
+	return IS_SUCCESS;
+}
+
+INT
+is_SetSubSampling (HIDS hCam, INT mode)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+	if (mode == IS_GET_SUBSAMPLING)
+		return cam->subsampling;
+	if (mode == IS_GET_SUPPORTED_SUBSAMPLING)
+		return IS_SUBSAMPLING_2X_VERTICAL | IS_SUBSAMPLING_2X_HORIZONTAL | IS_SUBSAMPLING_4X_VERTICAL | IS_SUBSAMPLING_4X_HORIZONTAL;
+
+	cam->subsampling = mode;
+	sim_reset_aoi (cam);
+
+	return IS_SUCCESS;
+}
+
+INT
+is_PixelClock (HIDS hCam, UINT nCommand, void *pParam, UINT cbSizeOfParam)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	switch (nCommand) {
+	case IS_PIXELCLOCK_CMD_GET:
+		*(UINT *) pParam = cam->pixelclock;
+		break;
+	case IS_PIXELCLOCK_CMD_SET:
+		if (*(UINT *) pParam < 5 || *(UINT *) pParam > 100)
+			return IS_INVALID_PARAMETER;
+		cam->pixelclock = *(UINT *) pParam;
+		break;
+	case IS_PIXELCLOCK_CMD_GET_RANGE:
+		((UINT *) pParam)[0] = 5;
+		((UINT *) pParam)[1] = 100;
+		((UINT *) pParam)[2] = 1;
+		break;
+	default:
+		return IS_NOT_SUPPORTED;
+	}
+
+	return IS_SUCCESS;
+}
+
+INT
+is_SetFrameRate (HIDS hCam, double FPS, double *newFPS)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	g_mutex_lock (&cam->lock);
+	if (FPS != IS_GET_FRAMERATE)
+		cam->fps = CLAMP (FPS, 0.5, sim_config.max_fps);
+	// the exposure cannot be longer than the frame
+	cam->exposure = MIN (cam->exposure, 1000.0 / cam->fps);
+	if (newFPS != NULL)
+		*newFPS = cam->fps;
+	g_cond_broadcast (&cam->cond);
+	g_mutex_unlock (&cam->lock);
+
+	return IS_SUCCESS;
+}
+
+INT
+is_GetFrameTimeRange (HIDS hCam, double *min, double *max, double *intervall)
+{
+	if (sim_get_camera (hCam) == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	*min = 1.0 / sim_config.max_fps;
+	*max = 2.0;
+	*intervall = 1e-5;
+
+	return IS_SUCCESS;
+}
+
+INT
+is_Exposure (HIDS hCam, UINT nCommand, void *pParam, UINT cbSizeOfParam)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+	double *value = (double *) pParam;
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	switch (nCommand) {
+	case IS_EXPOSURE_CMD_SET_EXPOSURE:
+		// 0 means the longest exposure the frame rate allows
+		cam->exposure = *value <= 0.0 ? 1000.0 / cam->fps : CLAMP (*value, 0.01, 1000.0 / cam->fps);
+		break;
+	case IS_EXPOSURE_CMD_GET_EXPOSURE:
+		*value = cam->exposure;
+		break;
+	case IS_EXPOSURE_CMD_GET_EXPOSURE_RANGE:
+		value[0] = 0.01;
+		value[1] = 1000.0 / cam->fps;
+		value[2] = 0.01;
+		break;
+	case IS_EXPOSURE_CMD_GET_EXPOSURE_RANGE_MIN:
+		*value = 0.01;
+		break;
+	case IS_EXPOSURE_CMD_GET_EXPOSURE_RANGE_MAX:
+		*value = 1000.0 / cam->fps;
+		break;
+	default:
+		return IS_NOT_SUPPORTED;
+	}
+
+	return IS_SUCCESS;
+}
+
+INT
+is_SetHardwareGain (HIDS hCam, INT nMaster, INT nRed, INT nGreen, INT nBlue)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	switch (nMaster) {
+	case IS_GET_MASTER_GAIN:
+		return cam->gain;
+	case IS_GET_RED_GAIN:
+		return cam->rgain;
+	case IS_GET_GREEN_GAIN:
+		return cam->ggain;
+	case IS_GET_BLUE_GAIN:
+		return cam->bgain;
+	}
+
+	if (nMaster != IS_IGNORE_PARAMETER)
+		cam->gain = CLAMP (nMaster, 0, 100);
+	if (nRed != IS_IGNORE_PARAMETER)
+		cam->rgain = CLAMP (nRed, 0, 100);
+	if (nGreen != IS_IGNORE_PARAMETER)
+		cam->ggain = CLAMP (nGreen, 0, 100);
+	if (nBlue != IS_IGNORE_PARAMETER)
+		cam->bgain = CLAMP (nBlue, 0, 100);
+
+	return IS_SUCCESS;
+}
+
+INT
+is_Blacklevel (HIDS hCam, UINT nCommand, void *pParam, UINT cbSizeOfParam)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	switch (nCommand) {
+	case IS_BLACKLEVEL_CMD_SET_OFFSET:
+		cam->blacklevel = CLAMP (*(INT *) pParam, 0, 255);
+		break;
+	case IS_BLACKLEVEL_CMD_GET_OFFSET:
+		*(INT *) pParam = cam->blacklevel;
+		break;
+	default:
+		return IS_NOT_SUPPORTED;
+	}
+
+	return IS_SUCCESS;
+}
+
+INT
+is_Gamma (HIDS hCam, UINT nCommand, void *pParam, UINT cbSizeOfParam)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	switch (nCommand) {
+	case IS_GAMMA_CMD_SET:
+		cam->gamma = *(INT *) pParam;
+		break;
+	case IS_GAMMA_CMD_GET:
+		*(INT *) pParam = cam->gamma;
+		break;
+	default:
+		return IS_NOT_SUPPORTED;
+	}
+
+	return IS_SUCCESS;
+}
+
+INT
+is_SetHardwareGamma (HIDS hCam, INT nMode)
+{
+	return sim_get_camera (hCam) != NULL ? IS_SUCCESS : IS_INVALID_CAMERA_HANDLE;
+}
+
+INT
+is_LUT (HIDS hCam, UINT nCommand, void *pParam, UINT cbSizeOfParams)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	switch (nCommand) {
+	case IS_LUT_CMD_GET_SUPPORT_INFO: {
+		IS_LUT_SUPPORT_INFO *info = (IS_LUT_SUPPORT_INFO *) pParam;
+
+		memset (info, 0, sizeof (*info));
+		info->bSupportLUTHardware = sim_config.hw_lut;
+		info->bSupportLUTSoftware = TRUE;
+		info->nBitsHardware = info->nBitsSoftware = 8;
+		info->nChannelsHardware = info->nChannelsSoftware = 3;
+		break;
+	}
+	case IS_LUT_CMD_SET_MODE:
+		if (*(INT *) pParam == IS_LUT_MODE_ID_FORCE_HARDWARE && !sim_config.hw_lut)
+			return IS_NOT_SUPPORTED;
+		break;
+	case IS_LUT_CMD_SET_ENABLED:
+	case IS_LUT_CMD_SET_USER_LUT:
+		break;
+	default:
+		return IS_NOT_SUPPORTED;
+	}
+
+	return IS_SUCCESS;
+}
+
+// Only the sensor bit depths
+INT
+is_DeviceFeature (HIDS hCam, UINT nCommand, void *pParam, UINT cbSizeOfParam)
+{
+	if (sim_get_camera (hCam) == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+	if (nCommand != IS_DEVICE_FEATURE_CMD_GET_SUPPORTED_SENSOR_BIT_DEPTHS)
+		return IS_NOT_SUPPORTED;
+
+	*(UINT *) pParam = IS_SENSOR_BIT_DEPTH_8_BIT
+			| (sim_config.max_bits >= 10 ? IS_SENSOR_BIT_DEPTH_10_BIT : 0)
+			| (sim_config.max_bits >= 12 ? IS_SENSOR_BIT_DEPTH_12_BIT : 0);
+
+	return IS_SUCCESS;
+}
+
+// Only removal and arrival, the events the plugin waits for
+INT
+is_EnableEvent (HIDS hCam, INT which)
+{
+	if (which == IS_SET_EVENT_NEW_DEVICE)
+		return IS_SUCCESS;
+	if (which != IS_SET_EVENT_REMOVE)
+		return IS_NOT_SUPPORTED;
+
+	return sim_get_camera (hCam) != NULL ? IS_SUCCESS : IS_INVALID_CAMERA_HANDLE;
+}
+
+INT
+is_DisableEvent (HIDS hCam, INT which)
+{
+	return is_EnableEvent (hCam, which);
+}
+
+INT
+is_WaitEvent (HIDS hCam, INT which, INT nTimeout)
+{
+	SimCamera *cam;
+	gint64 now = g_get_monotonic_time (), end_time = now + (gint64) nTimeout * 1000, back = G_MAXINT64;
+	gboolean removed;
+	gint i;
+
+	if (which == IS_SET_EVENT_NEW_DEVICE) {
+		// the next unplugged camera to come back
+		sim_init ();
+		for (i = 0; i < sim_config.cameras; i++)
+			if (sim_cameras[i].gone_until > now)
+				back = MIN (back, sim_cameras[i].gone_until);
+		g_usleep (MIN (back, end_time) - now);
+		return back <= end_time ? IS_SUCCESS : IS_TIMED_OUT;
+	}
+	if (which != IS_SET_EVENT_REMOVE)
+		return IS_NOT_SUPPORTED;
+
+	cam = sim_get_camera (hCam);
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	// signalled once
+	g_mutex_lock (&cam->lock);
+	while (!cam->removed && g_cond_wait_until (&cam->cond, &cam->lock, end_time))
+		;
+	removed = cam->removed && !cam->remove_signalled;
+	if (removed)
+		cam->remove_signalled = TRUE;
+	g_mutex_unlock (&cam->lock);
+
+	return removed ? IS_SUCCESS : IS_TIMED_OUT;
+}
+
+// A parameter set loads nothing, the file must exist
+INT
+is_ParameterSet (HIDS hCam, UINT nCommand, void *pParam, UINT cbSizeOfParams)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+	gchar *path;
+	gboolean exists;
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	switch (nCommand) {
+	case IS_PARAMETERSET_CMD_LOAD_EEPROM:
+		return IS_SUCCESS;
+	case IS_PARAMETERSET_CMD_LOAD_FILE:
+		if (pParam == NULL)
+			return IS_INVALID_PARAMETER;
+		path = g_ucs4_to_utf8 ((const gunichar *) pParam, -1, NULL, NULL, NULL);
+		exists = path != NULL && g_file_test (path, G_FILE_TEST_IS_REGULAR);
+		g_free (path);
+		return exists ? IS_SUCCESS : IS_NO_SUCCESS;
+	default:
+		return IS_NOT_SUPPORTED;
+	}
+}
+
+INT
+is_SetRopEffect (HIDS hCam, INT effect, INT param, INT reserved)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	if (param)
+		cam->rop |= effect;
+	else
+		cam->rop &= ~effect;
+
+	return IS_SUCCESS;
+}
+
+INT
+is_SetAutoParameter (HIDS hCam, INT param, double *pval1, double *pval2)
+{
+	return sim_get_camera (hCam) != NULL ? IS_SUCCESS : IS_INVALID_CAMERA_HANDLE;
+}
+
+INT
+is_IO (HIDS hCam, UINT nCommand, void *pParam, UINT cbSizeOfParam)
+{
+	if (sim_get_camera (hCam) == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	// the flash output goes nowhere
+	switch (nCommand) {
+	case IS_IO_CMD_FLASH_SET_MODE:
+	case IS_IO_CMD_FLASH_SET_PARAMS:
+	case IS_IO_CMD_FLASH_SET_AUTO_FREERUN:
+		return IS_SUCCESS;
+	default:
+		return IS_NOT_SUPPORTED;
+	}
+}
+
+INT
+is_SetExternalTrigger (HIDS hCam, INT nTriggerMode)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+	if (nTriggerMode == IS_GET_EXTERNALTRIGGER)
+		return cam->trigger;
+
+	switch (nTriggerMode) {
+	case IS_SET_TRIGGER_OFF:
+	case IS_SET_TRIGGER_SOFTWARE:
+	case IS_SET_TRIGGER_LO_HI:
+	case IS_SET_TRIGGER_HI_LO:
+		g_mutex_lock (&cam->lock);
+		cam->trigger = nTriggerMode;
+		g_cond_broadcast (&cam->cond);
+		g_mutex_unlock (&cam->lock);
+		return IS_SUCCESS;
+	default:
+		return IS_INVALID_PARAMETER;
+	}
+}
+
+INT
+is_CaptureVideo (HIDS hCam, INT Wait)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+	if (Wait == IS_GET_LIVE)
+		return cam->live;
+
+	g_mutex_lock (&cam->lock);
+	cam->live = TRUE;
+	g_cond_broadcast (&cam->cond);
+	g_mutex_unlock (&cam->lock);
+
+	return IS_SUCCESS;
+}
+
+INT
+is_StopLiveVideo (HIDS hCam, INT Wait)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	g_mutex_lock (&cam->lock);
+	cam->live = FALSE;
+	cam->triggers = 0;
+	while (cam->filling)
+		g_cond_wait (&cam->cond, &cam->lock);
+	g_cond_broadcast (&cam->cond);
+	g_mutex_unlock (&cam->lock);
+
+	return IS_SUCCESS;
+}
+
+// One frame, after the exposure time
+INT
+is_FreezeVideo (HIDS hCam, INT Wait)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+
+	g_mutex_lock (&cam->lock);
+	cam->triggers++;
+	g_cond_broadcast (&cam->cond);
+	g_mutex_unlock (&cam->lock);
+
+	return IS_SUCCESS;
+}
+
+INT
+is_ForceTrigger (HIDS hCam)
+{
+	SimCamera *cam = sim_get_camera (hCam);
+
+	if (cam == NULL)
+		return IS_INVALID_CAMERA_HANDLE;
+	if (cam->trigger == IS_SET_TRIGGER_OFF)
+		return IS_NO_SUCCESS;
+
+	return is_FreezeVideo (hCam, IS_DONT_WAIT);
+}
@@ -3,6 +3,8 @@
 #endif
 
 #include "gstueyesrc.h"
+#include "gstueyedeviceprovider.h"
+#include "gstueyetracer.h"
 
 #define GST_CAT_DEFAULT gst_gstueye_debug
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
@@ -18,6 +20,15 @@ plugin_init (GstPlugin * plugin)
     return FALSE;
   }
 
+  if (!gst_device_provider_register (plugin, "ueyedeviceprovider", GST_RANK_PRIMARY,
+          GST_TYPE_UEYE_DEVICE_PROVIDER)) {
+    return FALSE;
+  }
+
+  if (!gst_tracer_register (plugin, "ueyetiming", GST_TYPE_UEYE_TRACER)) {
+    return FALSE;
+  }
+
   return TRUE;
 }
 
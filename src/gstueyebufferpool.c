@@ -0,0 +1,95 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ *
+ * Author P Barber
+ */
+// A video buffer pool whose buffers are aligned for the copy out of the SDK ring,
+// and whose pages are touched once at allocation rather than on the first frame copied into them.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h> // for memset
+
+#include "gstueyebufferpool.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_ueye_buffer_pool_debug);
+#define GST_CAT_DEFAULT gst_ueye_buffer_pool_debug
+
+#define UEYE_POOL_ALIGN 64  // bytes, same as the SDK ring memory
+
+G_DEFINE_TYPE (GstUEyeBufferPool, gst_ueye_buffer_pool, GST_TYPE_VIDEO_BUFFER_POOL);
+
+static gboolean
+gst_ueye_buffer_pool_set_config (GstBufferPool * pool, GstStructure * config)
+{
+	GstAllocator *allocator = NULL;
+	GstAllocationParams params;
+
+	// Make sure the memory is aligned whatever downstream asked for
+	if (!gst_buffer_pool_config_get_allocator (config, &allocator, &params))
+		gst_allocation_params_init (&params);
+	params.align = MAX (params.align, UEYE_POOL_ALIGN - 1);
+	gst_buffer_pool_config_set_allocator (config, allocator, &params);
+
+	return GST_BUFFER_POOL_CLASS (gst_ueye_buffer_pool_parent_class)->set_config (pool, config);
+}
+
+static GstFlowReturn
+gst_ueye_buffer_pool_alloc_buffer (GstBufferPool * pool, GstBuffer ** buffer,
+		GstBufferPoolAcquireParams * params)
+{
+	GstFlowReturn ret;
+	GstMapInfo minfo;
+
+	ret = GST_BUFFER_POOL_CLASS (gst_ueye_buffer_pool_parent_class)->alloc_buffer (pool, buffer, params);
+	if (ret != GST_FLOW_OK)
+		return ret;
+
+	// Fault the pages in now, buffers are then reused without touching the allocator again
+	if (gst_buffer_map (*buffer, &minfo, GST_MAP_WRITE)) {
+		memset (minfo.data, 0, minfo.size);
+		gst_buffer_unmap (*buffer, &minfo);
+	}
+
+	return GST_FLOW_OK;
+}
+
+static void
+gst_ueye_buffer_pool_class_init (GstUEyeBufferPoolClass * klass)
+{
+	GstBufferPoolClass *pool_class = GST_BUFFER_POOL_CLASS (klass);
+
+	GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "ueyebufferpool", 0,
+			"uEye output buffer pool");
+
+	pool_class->set_config = gst_ueye_buffer_pool_set_config;
+	pool_class->alloc_buffer = gst_ueye_buffer_pool_alloc_buffer;
+}
+
+static void
+gst_ueye_buffer_pool_init (GstUEyeBufferPool * pool)
+{
+}
+
+GstBufferPool *
+gst_ueye_buffer_pool_new (void)
+{
+	return g_object_new (GST_TYPE_UEYE_BUFFER_POOL, NULL);
+}
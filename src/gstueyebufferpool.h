@@ -0,0 +1,53 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _GST_UEYE_BUFFER_POOL_H_
+#define _GST_UEYE_BUFFER_POOL_H_
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <gst/video/gstvideopool.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_UEYE_BUFFER_POOL   (gst_ueye_buffer_pool_get_type())
+#define GST_UEYE_BUFFER_POOL(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_UEYE_BUFFER_POOL,GstUEyeBufferPool))
+#define GST_IS_UEYE_BUFFER_POOL(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_UEYE_BUFFER_POOL))
+
+typedef struct _GstUEyeBufferPool GstUEyeBufferPool;
+typedef struct _GstUEyeBufferPoolClass GstUEyeBufferPoolClass;
+
+// Pool of output buffers for frames that have to be copied out of the SDK ring
+struct _GstUEyeBufferPool
+{
+  GstVideoBufferPool parent;
+};
+
+struct _GstUEyeBufferPoolClass
+{
+  GstVideoBufferPoolClass parent_class;
+};
+
+GType gst_ueye_buffer_pool_get_type (void);
+
+GstBufferPool *gst_ueye_buffer_pool_new (void);
+
+G_END_DECLS
+
+#endif
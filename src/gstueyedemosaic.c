@@ -0,0 +1,541 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ *
+ * Author P Barber
+ */
+// Bayer demosaic of raw 8 bit sensor data into BGR, BGRx or RGB, done as the frame is copied out of the SDK ring.
+//
+// Every output pixel takes each colour from one of 5 candidate values worked out from the samples around it:
+// the sample itself, green interpolated across a red or blue site, the colour of the horizontal or of the
+// vertical neighbours at a green site, and the colour of the diagonal neighbours at a red or blue site.
+// Which candidate gives which colour only depends on the parity of the row and column, so a row is worked on
+// 16 pixels at a time with SSE2 or NEON and the candidates are picked lane by lane.
+// Samples past the edges are mirrored, which keeps the Bayer phase.
+//
+// The frame is split into bands of rows, one for each thread of a pool that lives as long as the format.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define UEYE_DEMOSAIC_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define UEYE_DEMOSAIC_NEON 1
+#endif
+
+#include "gstueyedemosaic.h"
+#include "gstueyelut.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_ueye_demosaic_debug);
+#define GST_CAT_DEFAULT gst_ueye_demosaic_debug
+
+#define DEMOSAIC_MIN_SIZE 4  // the 5x5 kernel mirrors at most 2 samples
+#define DEMOSAIC_MIN_BAND_ROWS 32  // fewer rows are not worth a thread
+#define DEMOSAIC_MIRROR(i, n) ((i) < 0 ? -(i) : ((i) >= (n) ? 2 * ((n) - 1) - (i) : (i)))
+#define DEMOSAIC_AVG(a, b) (((a) + (b) + 1) >> 1)
+
+// The candidate values
+enum
+{
+	Q_SAMPLE,  // the sample at this site
+	Q_CROSS,  // green at a red or blue site
+	Q_HORZ,  // the colour of the horizontal neighbours at a green site
+	Q_VERT,  // the colour of the vertical neighbours at a green site
+	Q_DIAG,  // the colour of the diagonal neighbours at a red or blue site
+	Q_N
+};
+
+enum
+{
+	CH_R,
+	CH_G,
+	CH_B
+};
+
+// The candidates at pixel x of the middle row of rows (y-2 to y+2)
+static inline void
+gst_ueye_demosaic_pixel (GstUEyeDemosaicMethod method, const guint8 * const rows[5], gint x, gint width, guint8 q[Q_N])
+{
+	const guint8 *a2 = rows[0], *a = rows[1], *c = rows[2], *b = rows[3], *b2 = rows[4];
+	gint xm1 = DEMOSAIC_MIRROR (x - 1, width), xp1 = DEMOSAIC_MIRROR (x + 1, width);
+
+	q[Q_SAMPLE] = c[x];
+	if (method == GST_UEYE_DEMOSAIC_BILINEAR) {
+		// Averages of averages, as the SIMD byte averages round
+		q[Q_HORZ] = DEMOSAIC_AVG (c[xm1], c[xp1]);
+		q[Q_VERT] = DEMOSAIC_AVG (a[x], b[x]);
+		q[Q_CROSS] = DEMOSAIC_AVG (q[Q_HORZ], q[Q_VERT]);
+		q[Q_DIAG] = DEMOSAIC_AVG (DEMOSAIC_AVG (a[xm1], a[xp1]), DEMOSAIC_AVG (b[xm1], b[xp1]));
+	}
+	else {
+		// Malvar-He-Cutler, the kernels are in sixteenths
+		gint xm2 = DEMOSAIC_MIRROR (x - 2, width), xp2 = DEMOSAIC_MIRROR (x + 2, width);
+		gint C = c[x];
+		gint H1 = c[xm1] + c[xp1], H2 = c[xm2] + c[xp2];
+		gint V1 = a[x] + b[x], V2 = a2[x] + b2[x];
+		gint D = a[xm1] + a[xp1] + b[xm1] + b[xp1];
+
+		q[Q_CROSS] = CLAMP ((8 * C + 4 * (H1 + V1) - 2 * (H2 + V2) + 8) >> 4, 0, 255);
+		q[Q_HORZ] = CLAMP ((10 * C + 8 * H1 - 2 * H2 - 2 * D + V2 + 8) >> 4, 0, 255);
+		q[Q_VERT] = CLAMP ((10 * C + 8 * V1 - 2 * V2 - 2 * D + H2 + 8) >> 4, 0, 255);
+		q[Q_DIAG] = CLAMP ((12 * C + 4 * D - 3 * (H2 + V2) + 8) >> 4, 0, 255);
+	}
+}
+
+static void
+gst_ueye_demosaic_row_scalar (GstUEyeDemosaic * demosaic, const guint8 * const rows[5], guint8 sel[3][2],
+		guint8 * planes, gint x0, gint x1)
+{
+	gint x, width = demosaic->width;
+	guint8 q[Q_N];
+
+	for (x = x0; x < x1; x++) {
+		gst_ueye_demosaic_pixel (demosaic->method, rows, x, width, q);
+		planes[x] = q[sel[CH_R][x & 1]];
+		planes[width + x] = q[sel[CH_G][x & 1]];
+		planes[2 * width + x] = q[sel[CH_B][x & 1]];
+	}
+}
+
+#if defined(UEYE_DEMOSAIC_SSE2)
+
+// Malvar-He-Cutler candidates for 8 pixels, the samples widened to 16 bits
+static inline void
+gst_ueye_demosaic_mhc_sse2 (__m128i C, __m128i H1, __m128i H2, __m128i V1, __m128i V2, __m128i D, __m128i q[Q_N])
+{
+	const __m128i round = _mm_set1_epi16 (8);
+	__m128i H2V2 = _mm_add_epi16 (H2, V2), D2 = _mm_slli_epi16 (D, 1);
+
+	q[Q_CROSS] = _mm_srai_epi16 (_mm_add_epi16 (_mm_sub_epi16 (_mm_add_epi16 (_mm_slli_epi16 (C, 3),
+			_mm_slli_epi16 (_mm_add_epi16 (H1, V1), 2)), _mm_slli_epi16 (H2V2, 1)), round), 4);
+	q[Q_HORZ] = _mm_srai_epi16 (_mm_add_epi16 (_mm_sub_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (C, _mm_set1_epi16 (10)),
+			_mm_add_epi16 (_mm_slli_epi16 (H1, 3), V2)), _mm_add_epi16 (_mm_slli_epi16 (H2, 1), D2)), round), 4);
+	q[Q_VERT] = _mm_srai_epi16 (_mm_add_epi16 (_mm_sub_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (C, _mm_set1_epi16 (10)),
+			_mm_add_epi16 (_mm_slli_epi16 (V1, 3), H2)), _mm_add_epi16 (_mm_slli_epi16 (V2, 1), D2)), round), 4);
+	q[Q_DIAG] = _mm_srai_epi16 (_mm_add_epi16 (_mm_sub_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (C, _mm_set1_epi16 (12)),
+			_mm_slli_epi16 (D, 2)), _mm_mullo_epi16 (H2V2, _mm_set1_epi16 (3))), round), 4);
+}
+
+// The middle of a row, 16 pixels at a time, returns the first pixel left for the scalar code
+static gint
+gst_ueye_demosaic_row_simd (GstUEyeDemosaic * demosaic, const guint8 * const rows[5], guint8 sel[3][2],
+		guint8 * planes)
+{
+	const guint8 *a2 = rows[0], *a = rows[1], *c = rows[2], *b = rows[3], *b2 = rows[4];
+	const __m128i zero = _mm_setzero_si128 ();
+	const __m128i even = _mm_set1_epi16 (0x00ff);  // the even columns of 16 bytes
+	gint x, width = demosaic->width, ch;
+
+#define LOAD(p) _mm_loadu_si128 ((const __m128i *) (p))
+	for (x = 2; x + 18 <= width; x += 16) {
+		__m128i q[Q_N];
+
+		q[Q_SAMPLE] = LOAD (c + x);
+		if (demosaic->method == GST_UEYE_DEMOSAIC_BILINEAR) {
+			q[Q_HORZ] = _mm_avg_epu8 (LOAD (c + x - 1), LOAD (c + x + 1));
+			q[Q_VERT] = _mm_avg_epu8 (LOAD (a + x), LOAD (b + x));
+			q[Q_CROSS] = _mm_avg_epu8 (q[Q_HORZ], q[Q_VERT]);
+			q[Q_DIAG] = _mm_avg_epu8 (_mm_avg_epu8 (LOAD (a + x - 1), LOAD (a + x + 1)),
+					_mm_avg_epu8 (LOAD (b + x - 1), LOAD (b + x + 1)));
+		}
+		else {
+			__m128i cm2 = LOAD (c + x - 2), cm1 = LOAD (c + x - 1), cp1 = LOAD (c + x + 1), cp2 = LOAD (c + x + 2);
+			__m128i a0 = LOAD (a + x), am1 = LOAD (a + x - 1), ap1 = LOAD (a + x + 1);
+			__m128i b0 = LOAD (b + x), bm1 = LOAD (b + x - 1), bp1 = LOAD (b + x + 1);
+			__m128i a20 = LOAD (a2 + x), b20 = LOAD (b2 + x);
+			__m128i lo[Q_N], hi[Q_N];
+			gint i;
+
+#define LO(v) _mm_unpacklo_epi8 (v, zero)
+#define HI(v) _mm_unpackhi_epi8 (v, zero)
+			gst_ueye_demosaic_mhc_sse2 (LO (q[Q_SAMPLE]), _mm_add_epi16 (LO (cm1), LO (cp1)), _mm_add_epi16 (LO (cm2), LO (cp2)),
+					_mm_add_epi16 (LO (a0), LO (b0)), _mm_add_epi16 (LO (a20), LO (b20)),
+					_mm_add_epi16 (_mm_add_epi16 (LO (am1), LO (ap1)), _mm_add_epi16 (LO (bm1), LO (bp1))), lo);
+			gst_ueye_demosaic_mhc_sse2 (HI (q[Q_SAMPLE]), _mm_add_epi16 (HI (cm1), HI (cp1)), _mm_add_epi16 (HI (cm2), HI (cp2)),
+					_mm_add_epi16 (HI (a0), HI (b0)), _mm_add_epi16 (HI (a20), HI (b20)),
+					_mm_add_epi16 (_mm_add_epi16 (HI (am1), HI (ap1)), _mm_add_epi16 (HI (bm1), HI (bp1))), hi);
+#undef LO
+#undef HI
+			// packing saturates to 0-255
+			for (i = Q_CROSS; i < Q_N; i++)
+				q[i] = _mm_packus_epi16 (lo[i], hi[i]);
+		}
+
+		// x is even, so even bytes are even columns
+		for (ch = CH_R; ch <= CH_B; ch++) {
+			__m128i v = _mm_or_si128 (_mm_and_si128 (even, q[sel[ch][0]]), _mm_andnot_si128 (even, q[sel[ch][1]]));
+
+			_mm_storeu_si128 ((__m128i *) (planes + ch * width + x), v);
+		}
+	}
+#undef LOAD
+
+	return x;
+}
+
+#elif defined(UEYE_DEMOSAIC_NEON)
+
+static inline void
+gst_ueye_demosaic_mhc_neon (int16x8_t C, int16x8_t H1, int16x8_t H2, int16x8_t V1, int16x8_t V2, int16x8_t D, int16x8_t q[Q_N])
+{
+	int16x8_t H2V2 = vaddq_s16 (H2, V2), D2 = vshlq_n_s16 (D, 1);
+
+	q[Q_CROSS] = vrshrq_n_s16 (vsubq_s16 (vaddq_s16 (vshlq_n_s16 (C, 3), vshlq_n_s16 (vaddq_s16 (H1, V1), 2)),
+			vshlq_n_s16 (H2V2, 1)), 4);
+	q[Q_HORZ] = vrshrq_n_s16 (vsubq_s16 (vaddq_s16 (vmulq_n_s16 (C, 10), vaddq_s16 (vshlq_n_s16 (H1, 3), V2)),
+			vaddq_s16 (vshlq_n_s16 (H2, 1), D2)), 4);
+	q[Q_VERT] = vrshrq_n_s16 (vsubq_s16 (vaddq_s16 (vmulq_n_s16 (C, 10), vaddq_s16 (vshlq_n_s16 (V1, 3), H2)),
+			vaddq_s16 (vshlq_n_s16 (V2, 1), D2)), 4);
+	q[Q_DIAG] = vrshrq_n_s16 (vsubq_s16 (vaddq_s16 (vmulq_n_s16 (C, 12), vshlq_n_s16 (D, 2)),
+			vmulq_n_s16 (H2V2, 3)), 4);
+}
+
+static gint
+gst_ueye_demosaic_row_simd (GstUEyeDemosaic * demosaic, const guint8 * const rows[5], guint8 sel[3][2],
+		guint8 * planes)
+{
+	const guint8 *a2 = rows[0], *a = rows[1], *c = rows[2], *b = rows[3], *b2 = rows[4];
+	const uint8x16_t even = vreinterpretq_u8_u16 (vdupq_n_u16 (0x00ff));
+	gint x, width = demosaic->width, ch;
+
+	for (x = 2; x + 18 <= width; x += 16) {
+		uint8x16_t q[Q_N];
+
+		q[Q_SAMPLE] = vld1q_u8 (c + x);
+		if (demosaic->method == GST_UEYE_DEMOSAIC_BILINEAR) {
+			q[Q_HORZ] = vrhaddq_u8 (vld1q_u8 (c + x - 1), vld1q_u8 (c + x + 1));
+			q[Q_VERT] = vrhaddq_u8 (vld1q_u8 (a + x), vld1q_u8 (b + x));
+			q[Q_CROSS] = vrhaddq_u8 (q[Q_HORZ], q[Q_VERT]);
+			q[Q_DIAG] = vrhaddq_u8 (vrhaddq_u8 (vld1q_u8 (a + x - 1), vld1q_u8 (a + x + 1)),
+					vrhaddq_u8 (vld1q_u8 (b + x - 1), vld1q_u8 (b + x + 1)));
+		}
+		else {
+			uint8x16_t cm2 = vld1q_u8 (c + x - 2), cm1 = vld1q_u8 (c + x - 1), cp1 = vld1q_u8 (c + x + 1), cp2 = vld1q_u8 (c + x + 2);
+			uint8x16_t a0 = vld1q_u8 (a + x), am1 = vld1q_u8 (a + x - 1), ap1 = vld1q_u8 (a + x + 1);
+			uint8x16_t b0 = vld1q_u8 (b + x), bm1 = vld1q_u8 (b + x - 1), bp1 = vld1q_u8 (b + x + 1);
+			uint8x16_t a20 = vld1q_u8 (a2 + x), b20 = vld1q_u8 (b2 + x);
+			int16x8_t lo[Q_N], hi[Q_N];
+			gint i;
+
+#define LO(v) vreinterpretq_s16_u16 (vmovl_u8 (vget_low_u8 (v)))
+#define HI(v) vreinterpretq_s16_u16 (vmovl_u8 (vget_high_u8 (v)))
+			gst_ueye_demosaic_mhc_neon (LO (q[Q_SAMPLE]), vaddq_s16 (LO (cm1), LO (cp1)), vaddq_s16 (LO (cm2), LO (cp2)),
+					vaddq_s16 (LO (a0), LO (b0)), vaddq_s16 (LO (a20), LO (b20)),
+					vaddq_s16 (vaddq_s16 (LO (am1), LO (ap1)), vaddq_s16 (LO (bm1), LO (bp1))), lo);
+			gst_ueye_demosaic_mhc_neon (HI (q[Q_SAMPLE]), vaddq_s16 (HI (cm1), HI (cp1)), vaddq_s16 (HI (cm2), HI (cp2)),
+					vaddq_s16 (HI (a0), HI (b0)), vaddq_s16 (HI (a20), HI (b20)),
+					vaddq_s16 (vaddq_s16 (HI (am1), HI (ap1)), vaddq_s16 (HI (bm1), HI (bp1))), hi);
+#undef LO
+#undef HI
+			for (i = Q_CROSS; i < Q_N; i++)
+				q[i] = vcombine_u8 (vqmovun_s16 (lo[i]), vqmovun_s16 (hi[i]));
+		}
+
+		for (ch = CH_R; ch <= CH_B; ch++)
+			vst1q_u8 (planes + ch * width + x, vbslq_u8 (even, q[sel[ch][0]], q[sel[ch][1]]));
+	}
+
+	return x;
+}
+
+#endif
+
+// Interleave the colour planes of a row into the output format
+static void
+gst_ueye_demosaic_pack_row (GstUEyeDemosaic * demosaic, const guint8 * planes, guint8 * dest)
+{
+	gint width = demosaic->width, x = 0;
+	const guint8 *r = planes, *g = planes + width, *bl = planes + 2 * width;
+
+	switch (demosaic->format) {
+	case GST_VIDEO_FORMAT_BGRx:
+#if defined(UEYE_DEMOSAIC_SSE2)
+		{
+			const __m128i ones = _mm_set1_epi8 ((char) 0xff);
+
+			for (; x + 16 <= width; x += 16) {
+				__m128i vb = _mm_loadu_si128 ((const __m128i *) (bl + x));
+				__m128i vg = _mm_loadu_si128 ((const __m128i *) (g + x));
+				__m128i vr = _mm_loadu_si128 ((const __m128i *) (r + x));
+				__m128i bg_lo = _mm_unpacklo_epi8 (vb, vg), bg_hi = _mm_unpackhi_epi8 (vb, vg);
+				__m128i rx_lo = _mm_unpacklo_epi8 (vr, ones), rx_hi = _mm_unpackhi_epi8 (vr, ones);
+				__m128i *out = (__m128i *) (dest + 4 * x);
+
+				_mm_storeu_si128 (out, _mm_unpacklo_epi16 (bg_lo, rx_lo));
+				_mm_storeu_si128 (out + 1, _mm_unpackhi_epi16 (bg_lo, rx_lo));
+				_mm_storeu_si128 (out + 2, _mm_unpacklo_epi16 (bg_hi, rx_hi));
+				_mm_storeu_si128 (out + 3, _mm_unpackhi_epi16 (bg_hi, rx_hi));
+			}
+		}
+#elif defined(UEYE_DEMOSAIC_NEON)
+		for (; x + 16 <= width; x += 16) {
+			uint8x16x4_t v;
+
+			v.val[0] = vld1q_u8 (bl + x);
+			v.val[1] = vld1q_u8 (g + x);
+			v.val[2] = vld1q_u8 (r + x);
+			v.val[3] = vdupq_n_u8 (0xff);
+			vst4q_u8 (dest + 4 * x, v);
+		}
+#endif
+		for (; x < width; x++) {
+			dest[4 * x] = bl[x];
+			dest[4 * x + 1] = g[x];
+			dest[4 * x + 2] = r[x];
+			dest[4 * x + 3] = 0xff;
+		}
+		break;
+	case GST_VIDEO_FORMAT_RGB:
+		// RGB is BGR with the planes swapped
+		r = planes + 2 * width;
+		bl = planes;
+		// fall through
+	case GST_VIDEO_FORMAT_BGR:
+	default:
+#if defined(UEYE_DEMOSAIC_NEON)
+		for (; x + 16 <= width; x += 16) {
+			uint8x16x3_t v;
+
+			v.val[0] = vld1q_u8 (bl + x);
+			v.val[1] = vld1q_u8 (g + x);
+			v.val[2] = vld1q_u8 (r + x);
+			vst3q_u8 (dest + 3 * x, v);
+		}
+#endif
+		for (; x < width; x++) {
+			dest[3 * x] = bl[x];
+			dest[3 * x + 1] = g[x];
+			dest[3 * x + 2] = r[x];
+		}
+		break;
+	}
+}
+
+static void
+gst_ueye_demosaic_band (GstUEyeDemosaicBand * band)
+{
+	GstUEyeDemosaic *demosaic = band->demosaic;
+	gint width = demosaic->width, height = demosaic->height;
+	gint x, y, i;
+
+	for (y = band->first; y < band->last; y++) {
+		const guint8 *rows[5];
+
+		for (i = 0; i < 5; i++)
+			rows[i] = demosaic->src + DEMOSAIC_MIRROR (y + i - 2, height) * demosaic->src_stride;
+
+		// The edge columns mirror, the middle is done with SIMD if we have it
+		gst_ueye_demosaic_row_scalar (demosaic, rows, demosaic->select[y & 1], band->planes, 0, 2);
+#if defined(UEYE_DEMOSAIC_SSE2) || defined(UEYE_DEMOSAIC_NEON)
+		x = gst_ueye_demosaic_row_simd (demosaic, rows, demosaic->select[y & 1], band->planes);
+#else
+		x = 2;
+#endif
+		gst_ueye_demosaic_row_scalar (demosaic, rows, demosaic->select[y & 1], band->planes, x, width);
+
+		// Look up the curve while the row is in cache
+		if (demosaic->lut != NULL)
+			gst_ueye_lut_apply (band->planes, band->planes, 3 * width, demosaic->lut);
+
+		gst_ueye_demosaic_pack_row (demosaic, band->planes, demosaic->dest + y * demosaic->dest_stride);
+	}
+}
+
+static void
+gst_ueye_demosaic_worker (gpointer data, gpointer user_data)
+{
+	GstUEyeDemosaicBand *band = (GstUEyeDemosaicBand *) data;
+	GstUEyeDemosaic *demosaic = band->demosaic;
+
+	gst_ueye_demosaic_band (band);
+
+	g_mutex_lock (&demosaic->lock);
+	if (--demosaic->pending == 0)
+		g_cond_signal (&demosaic->cond);
+	g_mutex_unlock (&demosaic->lock);
+}
+
+// n_threads 0 uses a thread for each processor
+GstUEyeDemosaic *
+gst_ueye_demosaic_new (guint n_threads)
+{
+	GstUEyeDemosaic *demosaic;
+
+	GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "ueyedemosaic", 0,
+			"debug category for uEye Bayer demosaic");
+
+	demosaic = g_new0 (GstUEyeDemosaic, 1);
+	demosaic->n_threads = n_threads > 0 ? n_threads : g_get_num_processors ();
+	g_mutex_init (&demosaic->lock);
+	g_cond_init (&demosaic->cond);
+
+	return demosaic;
+}
+
+static void
+gst_ueye_demosaic_free_bands (GstUEyeDemosaic * demosaic)
+{
+	guint i;
+
+	// Waits for the threads to finish
+	if (demosaic->pool != NULL)
+		g_thread_pool_free (demosaic->pool, FALSE, TRUE);
+	demosaic->pool = NULL;
+
+	for (i = 0; i < demosaic->n_bands; i++)
+		g_free (demosaic->bands[i].planes);
+	g_free (demosaic->bands);
+	demosaic->bands = NULL;
+	demosaic->n_bands = 0;
+}
+
+void
+gst_ueye_demosaic_free (GstUEyeDemosaic * demosaic)
+{
+	gst_ueye_demosaic_free_bands (demosaic);
+	g_mutex_clear (&demosaic->lock);
+	g_cond_clear (&demosaic->cond);
+	g_free (demosaic);
+}
+
+static gint
+gst_ueye_demosaic_colour (gchar c)
+{
+	switch (c) {
+	case 'r':
+		return CH_R;
+	case 'b':
+		return CH_B;
+	case 'g':
+	default:
+		return CH_G;
+	}
+}
+
+// pattern is the video/x-bayer format, the colours of the top left 2x2 samples
+gboolean
+gst_ueye_demosaic_set_format (GstUEyeDemosaic * demosaic, GstUEyeDemosaicMethod method,
+		const gchar * pattern, GstVideoFormat format, gint width, gint height)
+{
+	GError *err = NULL;
+	guint i, n_bands;
+	gint p, col, ch, rows;
+
+	g_return_val_if_fail (method != GST_UEYE_DEMOSAIC_SDK, FALSE);
+	g_return_val_if_fail (pattern != NULL && strlen (pattern) == 4, FALSE);
+
+	if (width < DEMOSAIC_MIN_SIZE || height < DEMOSAIC_MIN_SIZE)
+		return FALSE;
+	if (format != GST_VIDEO_FORMAT_BGR && format != GST_VIDEO_FORMAT_BGRx && format != GST_VIDEO_FORMAT_RGB)
+		return FALSE;
+
+	// Which candidate gives each colour, for the parity of the row and column
+	for (p = 0; p < 2; p++) {
+		gboolean red_row = gst_ueye_demosaic_colour (pattern[2 * p]) == CH_R
+				|| gst_ueye_demosaic_colour (pattern[2 * p + 1]) == CH_R;
+
+		for (col = 0; col < 2; col++) {
+			gint site = gst_ueye_demosaic_colour (pattern[2 * p + col]);
+
+			for (ch = CH_R; ch <= CH_B; ch++) {
+				guint8 q;
+
+				if (ch == site)
+					q = Q_SAMPLE;
+				else if (site == CH_G)
+					q = (ch == CH_R) == red_row ? Q_HORZ : Q_VERT;
+				else
+					q = ch == CH_G ? Q_CROSS : Q_DIAG;
+				demosaic->select[p][ch][col] = q;
+			}
+		}
+	}
+
+	demosaic->method = method;
+	demosaic->format = format;
+
+	// Bands only change with the size
+	if (demosaic->width == width && demosaic->height == height && demosaic->bands != NULL)
+		return TRUE;
+
+	gst_ueye_demosaic_free_bands (demosaic);
+	demosaic->width = width;
+	demosaic->height = height;
+
+	n_bands = CLAMP (height / DEMOSAIC_MIN_BAND_ROWS, 1, (gint) demosaic->n_threads);
+	rows = (height + n_bands - 1) / n_bands;
+	demosaic->bands = g_new0 (GstUEyeDemosaicBand, n_bands);
+	for (i = 0; i < n_bands; i++) {
+		GstUEyeDemosaicBand *band = &demosaic->bands[i];
+
+		band->demosaic = demosaic;
+		band->first = MIN ((gint) i * rows, height);
+		band->last = MIN (band->first + rows, height);
+		band->planes = g_malloc (3 * width);
+	}
+	demosaic->n_bands = n_bands;
+
+	// Exclusive threads are started now and wait for work, not started for each frame
+	if (n_bands > 1) {
+		demosaic->pool = g_thread_pool_new (gst_ueye_demosaic_worker, demosaic, n_bands - 1, TRUE, &err);
+		if (demosaic->pool == NULL) {
+			GST_WARNING ("Could not start the demosaic threads, using one: %s", err ? err->message : "");
+			g_clear_error (&err);
+		}
+	}
+
+	GST_DEBUG ("%d x %d %s in %u bands of %d rows", width, height, pattern, n_bands, rows);
+
+	return TRUE;
+}
+
+// Demosaic a frame of 8 bit samples, the bands are shared between the pool and the calling thread
+void
+gst_ueye_demosaic_frame (GstUEyeDemosaic * demosaic, const guint8 * src, gint src_stride,
+		guint8 * dest, gint dest_stride, const guint8 * lut)
+{
+	guint i;
+
+	demosaic->src = src;
+	demosaic->src_stride = src_stride;
+	demosaic->dest = dest;
+	demosaic->dest_stride = dest_stride;
+	demosaic->lut = lut;
+
+	if (demosaic->pool == NULL) {
+		for (i = 0; i < demosaic->n_bands; i++)
+			gst_ueye_demosaic_band (&demosaic->bands[i]);
+		return;
+	}
+
+	demosaic->pending = demosaic->n_bands - 1;
+	for (i = 1; i < demosaic->n_bands; i++)
+		g_thread_pool_push (demosaic->pool, &demosaic->bands[i], NULL);
+
+	gst_ueye_demosaic_band (&demosaic->bands[0]);
+
+	g_mutex_lock (&demosaic->lock);
+	while (demosaic->pending > 0)
+		g_cond_wait (&demosaic->cond, &demosaic->lock);
+	g_mutex_unlock (&demosaic->lock);
+}
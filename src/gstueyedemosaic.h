@@ -0,0 +1,81 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _GST_UEYE_DEMOSAIC_H_
+#define _GST_UEYE_DEMOSAIC_H_
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstUEyeDemosaic GstUEyeDemosaic;
+typedef struct _GstUEyeDemosaicBand GstUEyeDemosaicBand;
+
+// Who turns the sensor's Bayer mosaic into colour pixels
+typedef enum
+{
+  GST_UEYE_DEMOSAIC_SDK,  // the SDK, single threaded, as it always has
+  GST_UEYE_DEMOSAIC_BILINEAR,  // us, average of the nearest samples of each colour
+  GST_UEYE_DEMOSAIC_MHC  // us, Malvar-He-Cutler 5x5 gradient corrected, sharper edges and less colour fringing
+} GstUEyeDemosaicMethod;
+
+// Rows [first, last) of the frame, worked on by one thread
+struct _GstUEyeDemosaicBand
+{
+  GstUEyeDemosaic *demosaic;
+  gint first;
+  gint last;
+  guint8 *planes;  // R, G and B rows of one output row, before they are interleaved
+};
+
+struct _GstUEyeDemosaic
+{
+  GstUEyeDemosaicMethod method;
+  GstVideoFormat format;  // BGR, BGRx or RGB
+  gint width;
+  gint height;
+  guint8 select[2][3][2];  // for row and column parity, which candidate value gives each colour
+
+  guint n_threads;
+  guint n_bands;
+  GstUEyeDemosaicBand *bands;
+  GThreadPool *pool;  // n_bands - 1 threads, the caller works on the first band
+
+  // the frame being demosaiced
+  const guint8 *src;
+  gint src_stride;
+  guint8 *dest;
+  gint dest_stride;
+  const guint8 *lut;  // 8 bit curve applied to the colour values, or NULL
+  gint pending;  // bands still being worked on
+  GMutex lock;
+  GCond cond;
+};
+
+GstUEyeDemosaic *gst_ueye_demosaic_new (guint n_threads);
+void gst_ueye_demosaic_free (GstUEyeDemosaic * demosaic);
+gboolean gst_ueye_demosaic_set_format (GstUEyeDemosaic * demosaic, GstUEyeDemosaicMethod method,
+    const gchar * pattern, GstVideoFormat format, gint width, gint height);
+void gst_ueye_demosaic_frame (GstUEyeDemosaic * demosaic, const guint8 * src, gint src_stride,
+    guint8 * dest, gint dest_stride, const guint8 * lut);
+
+G_END_DECLS
+
+#endif
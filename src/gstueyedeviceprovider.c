@@ -0,0 +1,270 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ *
+ * Author P Barber
+ */
+// Device provider listing the attached uEye cameras from the SDK camera list.
+// Cameras not in use are opened briefly for their sensor information, no image memory is allocated
+// and capture is not started. Each device makes a ueyesrc bound to the camera by its serial number.
+//
+// gst-device-monitor-1.0 Video/Source
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstueyedeviceprovider.h"
+#include "gstueyeformat.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_ueye_device_provider_debug);
+#define GST_CAT_DEFAULT gst_ueye_device_provider_debug
+
+G_DEFINE_TYPE (GstUEyeDeviceProvider, gst_ueye_device_provider, GST_TYPE_DEVICE_PROVIDER);
+G_DEFINE_TYPE (GstUEyeDevice, gst_ueye_device, GST_TYPE_DEVICE);
+
+UEYE_CAMERA_LIST *
+gst_ueye_camera_list_new (void)
+{
+	UEYE_CAMERA_LIST *list;
+	INT nCameras = 0;
+
+	if (is_GetNumberOfCameras(&nCameras) != IS_SUCCESS || nCameras < 1)
+		return NULL;
+
+	// UEYE_CAMERA_LIST ends with room for one camera
+	list = (UEYE_CAMERA_LIST *) g_malloc0(sizeof(UEYE_CAMERA_LIST) + (nCameras - 1) * sizeof(UEYE_CAMERA_INFO));
+	list->dwCount = nCameras;
+	if (is_GetCameraList(list) != IS_SUCCESS) {
+		g_free(list);
+		return NULL;
+	}
+
+	// A camera may have gone since we counted them
+	list->dwCount = MIN(list->dwCount, (ULONG) nCameras);
+
+	return list;
+}
+
+// The camera with this serial number, or if there is no serial number, this device id
+const UEYE_CAMERA_INFO *
+gst_ueye_camera_list_find (const UEYE_CAMERA_LIST * list, const gchar * serial, gint device_id)
+{
+	ULONG i;
+
+	if (list == NULL)
+		return NULL;
+
+	for (i = 0; i < list->dwCount; i++) {
+		const UEYE_CAMERA_INFO *info = &list->uci[i];
+
+		if (serial != NULL && serial[0] != '\0') {
+			if (strncmp(info->SerNo, serial, sizeof(info->SerNo)) == 0)
+				return info;
+		}
+		else if (info->dwDeviceID == (DWORD) device_id)
+			return info;
+	}
+
+	return NULL;
+}
+
+gchar *
+gst_ueye_camera_info_get_serial (const UEYE_CAMERA_INFO * info)
+{
+	// Not terminated if it fills the field
+	return g_strndup(info->SerNo, sizeof(info->SerNo));
+}
+
+// Caps for an idle camera from its sensor, sizes on the sensor's AOI steps
+static GstCaps *
+gst_ueye_device_get_camera_caps (const UEYE_CAMERA_INFO * info, SENSORINFO * sensor)
+{
+	HIDS hCam = (HIDS) (info->dwDeviceID | IS_USE_DEVICE_ID);
+	IS_SIZE_2D min, max, inc;
+	GstCaps *caps;
+
+	if (info->dwInUse || is_InitCamera(&hCam, NULL) != IS_SUCCESS) {
+		GST_DEBUG ("Camera %d is in use, listing it with the template caps", info->dwDeviceID);
+		return NULL;
+	}
+
+	if (is_GetSensorInfo(hCam, sensor) != IS_SUCCESS) {
+		is_ExitCamera(hCam);
+		return NULL;
+	}
+
+	max.s32Width = sensor->nMaxWidth;
+	max.s32Height = sensor->nMaxHeight;
+	is_AOI(hCam, IS_AOI_IMAGE_GET_SIZE_MAX, (void*)&max, sizeof(max));
+	min = max;
+	is_AOI(hCam, IS_AOI_IMAGE_GET_SIZE_MIN, (void*)&min, sizeof(min));
+	inc.s32Width = 1;
+	inc.s32Height = 1;
+	is_AOI(hCam, IS_AOI_IMAGE_GET_SIZE_INC, (void*)&inc, sizeof(inc));
+	is_ExitCamera(hCam);
+
+	caps = gst_ueye_format_get_caps(sensor);
+	if (min.s32Width < max.s32Width && min.s32Height < max.s32Height) {
+		GValue width = G_VALUE_INIT, height = G_VALUE_INIT;
+
+		g_value_init (&width, GST_TYPE_INT_RANGE);
+		gst_value_set_int_range_step (&width, min.s32Width, max.s32Width - (max.s32Width - min.s32Width) % MAX(inc.s32Width, 1), MAX(inc.s32Width, 1));
+		g_value_init (&height, GST_TYPE_INT_RANGE);
+		gst_value_set_int_range_step (&height, min.s32Height, max.s32Height - (max.s32Height - min.s32Height) % MAX(inc.s32Height, 1), MAX(inc.s32Height, 1));
+		gst_caps_set_value (caps, "width", &width);
+		gst_caps_set_value (caps, "height", &height);
+		g_value_unset (&width);
+		g_value_unset (&height);
+	}
+	else {
+		gst_caps_set_simple (caps, "width", G_TYPE_INT, max.s32Width, "height", G_TYPE_INT, max.s32Height, NULL);
+	}
+	gst_caps_set_simple (caps, "framerate", GST_TYPE_FRACTION_RANGE, 0, 1, G_MAXINT, 1,
+			"pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1, NULL);
+
+	return caps;
+}
+
+static GstDevice *
+gst_ueye_device_new (const UEYE_CAMERA_INFO * info)
+{
+	GstUEyeDevice *device;
+	SENSORINFO sensor;
+	GstStructure *props;
+	GstCaps *caps;
+	gchar *serial, *model, *name;
+
+	memset(&sensor, 0, sizeof(sensor));
+	caps = gst_ueye_device_get_camera_caps(info, &sensor);
+	if (caps == NULL)
+		caps = gst_caps_from_string (GST_UEYE_FORMAT_TEMPLATE_CAPS);
+
+	serial = gst_ueye_camera_info_get_serial(info);
+	model = g_strndup(info->Model, sizeof(info->Model));
+	name = g_strdup_printf("uEye %s (%s)", model, serial);
+
+	props = gst_structure_new ("ueye-proplist",
+			"device.api", G_TYPE_STRING, "ueye",
+			"device.serial", G_TYPE_STRING, serial,
+			"device.id", G_TYPE_INT, (gint) info->dwDeviceID,
+			"device.camera-id", G_TYPE_INT, (gint) info->dwCameraID,
+			"device.model", G_TYPE_STRING, model,
+			"device.in-use", G_TYPE_BOOLEAN, info->dwInUse ? TRUE : FALSE, NULL);
+	if (sensor.strSensorName[0] != '\0')
+		gst_structure_set (props,
+				"device.sensor", G_TYPE_STRING, sensor.strSensorName,
+				"device.sensor-width", G_TYPE_INT, (gint) sensor.nMaxWidth,
+				"device.sensor-height", G_TYPE_INT, (gint) sensor.nMaxHeight, NULL);
+
+	GST_DEBUG ("Found %s, device id %d, caps %" GST_PTR_FORMAT, name, info->dwDeviceID, caps);
+
+	device = g_object_new (GST_TYPE_UEYE_DEVICE,
+			"display-name", name,
+			"caps", caps,
+			"device-class", "Video/Source",
+			"properties", props, NULL);
+	device->serial = serial;
+	device->device_id = info->dwDeviceID;
+
+	gst_caps_unref (caps);
+	gst_structure_free (props);
+	g_free (model);
+	g_free (name);
+
+	return GST_DEVICE (device);
+}
+
+static GList *
+gst_ueye_device_provider_probe (GstDeviceProvider * provider)
+{
+	UEYE_CAMERA_LIST *list;
+	GList *devices = NULL;
+	ULONG i;
+
+	list = gst_ueye_camera_list_new();
+	if (list == NULL)
+		return NULL;
+
+	for (i = 0; i < list->dwCount; i++)
+		devices = g_list_prepend (devices, gst_ueye_device_new (&list->uci[i]));
+
+	g_free (list);
+
+	return g_list_reverse (devices);
+}
+
+static void
+gst_ueye_device_provider_class_init (GstUEyeDeviceProviderClass * klass)
+{
+	GstDeviceProviderClass *dp_class = GST_DEVICE_PROVIDER_CLASS (klass);
+
+	GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "ueyedeviceprovider", 0,
+			"debug category for uEye device provider");
+
+	dp_class->probe = gst_ueye_device_provider_probe;
+
+	gst_device_provider_class_set_static_metadata (dp_class,
+			"uEye Device Provider", "Source/Video",
+			"Lists the attached IDS uEye cameras",
+			"Paul R. Barber <paul.barber@oncology.ox.ac.uk>");
+}
+
+static void
+gst_ueye_device_provider_init (GstUEyeDeviceProvider * provider)
+{
+}
+
+static GstElement *
+gst_ueye_device_create_element (GstDevice * device, const gchar * name)
+{
+	GstUEyeDevice *ueye_device = GST_UEYE_DEVICE (device);
+	GstElement *elem;
+
+	elem = gst_element_factory_make ("ueyesrc", name);
+	if (elem)
+		g_object_set (elem, "serial", ueye_device->serial, NULL);
+
+	return elem;
+}
+
+static void
+gst_ueye_device_finalize (GObject * object)
+{
+	GstUEyeDevice *device = GST_UEYE_DEVICE (object);
+
+	g_free (device->serial);
+
+	G_OBJECT_CLASS (gst_ueye_device_parent_class)->finalize (object);
+}
+
+static void
+gst_ueye_device_class_init (GstUEyeDeviceClass * klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+	GstDeviceClass *device_class = GST_DEVICE_CLASS (klass);
+
+	gobject_class->finalize = gst_ueye_device_finalize;
+	device_class->create_element = gst_ueye_device_create_element;
+}
+
+static void
+gst_ueye_device_init (GstUEyeDevice * device)
+{
+}
@@ -0,0 +1,75 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _GST_UEYE_DEVICE_PROVIDER_H_
+#define _GST_UEYE_DEVICE_PROVIDER_H_
+
+#include <gst/gst.h>
+
+#include  <ueye.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_UEYE_DEVICE_PROVIDER   (gst_ueye_device_provider_get_type())
+#define GST_UEYE_DEVICE_PROVIDER(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_UEYE_DEVICE_PROVIDER,GstUEyeDeviceProvider))
+
+#define GST_TYPE_UEYE_DEVICE   (gst_ueye_device_get_type())
+#define GST_UEYE_DEVICE(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_UEYE_DEVICE,GstUEyeDevice))
+
+typedef struct _GstUEyeDeviceProvider GstUEyeDeviceProvider;
+typedef struct _GstUEyeDeviceProviderClass GstUEyeDeviceProviderClass;
+typedef struct _GstUEyeDevice GstUEyeDevice;
+typedef struct _GstUEyeDeviceClass GstUEyeDeviceClass;
+
+// Lists the attached uEye cameras
+struct _GstUEyeDeviceProvider
+{
+  GstDeviceProvider parent;
+};
+
+struct _GstUEyeDeviceProviderClass
+{
+  GstDeviceProviderClass parent_class;
+};
+
+// A camera from the SDK camera list, makes a ueyesrc bound to it by serial number
+struct _GstUEyeDevice
+{
+  GstDevice parent;
+
+  gchar *serial;
+  gint device_id;
+};
+
+struct _GstUEyeDeviceClass
+{
+  GstDeviceClass parent_class;
+};
+
+GType gst_ueye_device_provider_get_type (void);
+GType gst_ueye_device_get_type (void);
+
+// The SDK camera list, free with g_free
+UEYE_CAMERA_LIST *gst_ueye_camera_list_new (void);
+const UEYE_CAMERA_INFO *gst_ueye_camera_list_find (const UEYE_CAMERA_LIST * list, const gchar * serial, gint device_id);
+gchar *gst_ueye_camera_info_get_serial (const UEYE_CAMERA_INFO * info);
+
+G_END_DECLS
+
+#endif
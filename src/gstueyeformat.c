@@ -0,0 +1,189 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ *
+ * Author P Barber
+ */
+// The output formats we support and the SDK colour modes that deliver them.
+//
+// 10 and 12 bit sensor modes are captured as GRAY16_LE or 16 bit Bayer. The camera is asked to send them packed,
+// so 12 bit samples take three quarters of the bus that 16 bits would, and the SDK unpacks them into the low bits
+// of 16 bit samples. As the frame is copied (or in place when the ring memory itself is pushed) we shift them up to the top,
+// where downstream expects them, and tell it how many bits are significant.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define UEYE_FORMAT_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define UEYE_FORMAT_NEON 1
+#endif
+
+#include "gstueyeformat.h"
+
+#define UEYE_COLOUR_SENSORS (IS_COLORMODE_BAYER | IS_COLORMODE_CBYCRY)
+#define UEYE_ALL_SENSORS (IS_COLORMODE_MONOCHROME | UEYE_COLOUR_SENSORS)
+#define UEYE_PACKED IS_CM_PREFER_PACKED_SOURCE_FORMAT  // the transfer, the image memory is 16 bit either way
+
+// In order of preference, so BGR stays the default for colour sensors and GRAY8 for mono ones.
+// The SDK has no YUY2 mode, UYVY is its packed 4:2:2.
+// GRAY16_LE and 16 bit Bayer take the deepest mode the sensor has, MONO16 and RAW16 are for sensors with no 10 or 12 bit mode.
+static const GstUEyeFormat gst_ueye_formats[] = {
+	{ GST_VIDEO_FORMAT_BGR,       IS_CM_BGR8_PACKED,  24,  8, UEYE_COLOUR_SENSORS },
+	{ GST_VIDEO_FORMAT_BGRx,      IS_CM_BGRA8_PACKED, 32,  8, UEYE_COLOUR_SENSORS },
+	{ GST_VIDEO_FORMAT_RGB,       IS_CM_RGB8_PACKED,  24,  8, UEYE_COLOUR_SENSORS },
+	{ GST_VIDEO_FORMAT_UYVY,      IS_CM_UYVY_PACKED,  16,  8, UEYE_COLOUR_SENSORS },
+	{ GST_VIDEO_FORMAT_GRAY8,     IS_CM_MONO8,         8,  8, UEYE_ALL_SENSORS },
+	{ GST_VIDEO_FORMAT_GRAY16_LE, IS_CM_MONO12 | UEYE_PACKED, 16, 12, UEYE_ALL_SENSORS },
+	{ GST_VIDEO_FORMAT_GRAY16_LE, IS_CM_MONO10 | UEYE_PACKED, 16, 10, UEYE_ALL_SENSORS },
+	{ GST_VIDEO_FORMAT_GRAY16_LE, IS_CM_MONO16,       16, 16, UEYE_ALL_SENSORS },
+	{ GST_VIDEO_FORMAT_UNKNOWN,   IS_CM_SENSOR_RAW8,   8,  8, IS_COLORMODE_BAYER },
+	{ GST_VIDEO_FORMAT_UNKNOWN,   IS_CM_SENSOR_RAW12 | UEYE_PACKED, 16, 12, IS_COLORMODE_BAYER },
+	{ GST_VIDEO_FORMAT_UNKNOWN,   IS_CM_SENSOR_RAW10 | UEYE_PACKED, 16, 10, IS_COLORMODE_BAYER },
+	{ GST_VIDEO_FORMAT_UNKNOWN,   IS_CM_SENSOR_RAW16, 16, 16, IS_COLORMODE_BAYER },
+};
+
+// video/x-bayer format for the colour of the sensor's top left pixel
+const gchar *
+gst_ueye_format_bayer_pattern (const SENSORINFO * sensor)
+{
+	switch (sensor->nUpperLeftBayerPixel){
+	case BAYER_PIXEL_RED:
+		return "rggb";
+	case BAYER_PIXEL_GREEN:
+		return "grbg";
+	case BAYER_PIXEL_BLUE:
+	default:
+		return "bggr";
+	}
+}
+
+// The mask of sample depths (1 << bits) the camera's sensor can deliver. 8 and 16 bits always can be,
+// 10 and 12 only if the camera says so.
+guint
+gst_ueye_format_get_depths (HIDS hCam)
+{
+	guint depths = (1 << 8) | (1 << 16);
+	UINT nBitDepths = 0;
+
+	if (is_DeviceFeature(hCam, IS_DEVICE_FEATURE_CMD_GET_SUPPORTED_SENSOR_BIT_DEPTHS, (void*)&nBitDepths, sizeof(nBitDepths)) == IS_SUCCESS) {
+		if (nBitDepths & IS_SENSOR_BIT_DEPTH_10_BIT)
+			depths |= 1 << 10;
+		if (nBitDepths & IS_SENSOR_BIT_DEPTH_12_BIT)
+			depths |= 1 << 12;
+	}
+
+	return depths;
+}
+
+static GstStructure *
+gst_ueye_format_to_structure (const SENSORINFO * sensor, const GstUEyeFormat * format)
+{
+	if (GST_UEYE_FORMAT_IS_BAYER(format)) {
+		gchar *bayer = g_strconcat (gst_ueye_format_bayer_pattern (sensor), format->nBitsPerPixel == 16 ? "16le" : NULL, NULL);
+		GstStructure *s = gst_structure_new ("video/x-bayer", "format", G_TYPE_STRING, bayer, NULL);
+
+		g_free (bayer);
+		return s;
+	}
+
+	return gst_structure_new ("video/x-raw",
+			"format", G_TYPE_STRING, gst_video_format_to_string (format->format),
+			"interlace-mode", G_TYPE_STRING, "progressive", NULL);
+}
+
+// Caps with a structure for every format this sensor can deliver, without size or frame rate
+GstCaps *
+gst_ueye_format_get_caps (const SENSORINFO * sensor)
+{
+	GstCaps *caps = gst_caps_new_empty ();
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (gst_ueye_formats); i++) {
+		// Monochrome sensors report 1 etc., the mask is a set of these
+		// The depths of one format give the same structure, merging keeps just the first
+		if (gst_ueye_formats[i].sensors & sensor->nColorMode)
+			caps = gst_caps_merge_structure (caps, gst_ueye_format_to_structure (sensor, &gst_ueye_formats[i]));
+	}
+
+	return caps;
+}
+
+// The format matching a fixed caps structure, at the deepest of the depths the sensor has,
+// or NULL if this sensor cannot deliver it
+const GstUEyeFormat *
+gst_ueye_format_from_structure (const SENSORINFO * sensor, guint depths, const GstStructure * s)
+{
+	const gchar *format = gst_structure_get_string (s, "format");
+	gboolean bayer = gst_structure_has_name (s, "video/x-bayer");
+	const gchar *pattern = gst_ueye_format_bayer_pattern (sensor);
+	guint i;
+
+	if (format == NULL)
+		return NULL;
+
+	for (i = 0; i < G_N_ELEMENTS (gst_ueye_formats); i++) {
+		const GstUEyeFormat *f = &gst_ueye_formats[i];
+
+		if (!(f->sensors & sensor->nColorMode) || !(depths & (1 << f->depth)))
+			continue;
+		if (bayer && GST_UEYE_FORMAT_IS_BAYER(f) && g_str_has_prefix (format, pattern)
+				&& g_str_equal (format + strlen (pattern), f->nBitsPerPixel == 16 ? "16le" : ""))
+			return f;
+		if (!bayer && !GST_UEYE_FORMAT_IS_BAYER(f) && gst_video_format_from_string (format) == f->format)
+			return f;
+	}
+
+	return NULL;
+}
+
+// Shift n 16 bit samples up by shift bits, from src into dest, which may be the same memory
+void
+gst_ueye_format_left_justify (guint16 * dest, const guint16 * src, gsize n, guint shift)
+{
+	gsize i = 0;
+
+#if defined(UEYE_FORMAT_SSE2)
+	__m128i count = _mm_cvtsi32_si128 (shift);
+
+	for (; i + 16 <= n; i += 16) {
+		__m128i a = _mm_loadu_si128 ((const __m128i *) (src + i));
+		__m128i b = _mm_loadu_si128 ((const __m128i *) (src + i + 8));
+
+		_mm_storeu_si128 ((__m128i *) (dest + i), _mm_sll_epi16 (a, count));
+		_mm_storeu_si128 ((__m128i *) (dest + i + 8), _mm_sll_epi16 (b, count));
+	}
+#elif defined(UEYE_FORMAT_NEON)
+	int16x8_t count = vdupq_n_s16 ((int16_t) shift);
+
+	for (; i + 16 <= n; i += 16) {
+		uint16x8_t a = vld1q_u16 (src + i);
+		uint16x8_t b = vld1q_u16 (src + i + 8);
+
+		vst1q_u16 (dest + i, vshlq_u16 (a, count));
+		vst1q_u16 (dest + i + 8, vshlq_u16 (b, count));
+	}
+#endif
+	for (; i < n; i++)
+		dest[i] = src[i] << shift;
+}
@@ -0,0 +1,60 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _GST_UEYE_FORMAT_H_
+#define _GST_UEYE_FORMAT_H_
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+#include  <ueye.h>
+
+G_BEGIN_DECLS
+
+// Caps for the pad template, the formats we may output, in any size
+#define GST_UEYE_FORMAT_TEMPLATE_CAPS \
+	GST_VIDEO_CAPS_MAKE ("{ BGR, BGRx, RGB, UYVY, GRAY8, GRAY16_LE }") "; " \
+	"video/x-bayer, format=(string){ bggr, rggb, grbg, gbrg, bggr16le, rggb16le, grbg16le, gbrg16le }, " \
+	"width=(int)[1,MAX], height=(int)[1,MAX], framerate=(fraction)[0/1,MAX]"
+
+typedef struct _GstUEyeFormat GstUEyeFormat;
+
+// An output format and the SDK colour mode that delivers it
+struct _GstUEyeFormat
+{
+  GstVideoFormat format;  // GST_VIDEO_FORMAT_UNKNOWN for raw Bayer (video/x-bayer)
+  INT nColorMode;  // SDK colour mode, for is_SetColorMode
+  INT nBitsPerPixel;  // in the SDK image memory
+  INT depth;  // significant bits per sample, 10 and 12 bit samples are in the low bits of 16 until we copy them
+  guint sensors;  // mask of the SENSORINFO nColorMode types that can deliver it
+};
+
+#define GST_UEYE_FORMAT_IS_BAYER(f) ((f)->format == GST_VIDEO_FORMAT_UNKNOWN)
+// Bits to shift 16 bit samples up by, so that they fill the range GRAY16_LE and 16 bit Bayer are expected to use
+#define GST_UEYE_FORMAT_SHIFT(f) ((f)->depth > 8 ? 16 - (f)->depth : 0)
+
+GstCaps *gst_ueye_format_get_caps (const SENSORINFO * sensor);
+const GstUEyeFormat *gst_ueye_format_from_structure (const SENSORINFO * sensor, guint depths, const GstStructure * s);
+const gchar *gst_ueye_format_bayer_pattern (const SENSORINFO * sensor);
+guint gst_ueye_format_get_depths (HIDS hCam);
+void gst_ueye_format_left_justify (guint16 * dest, const guint16 * src, gsize n, guint shift);
+
+G_END_DECLS
+
+#endif
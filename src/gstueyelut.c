@@ -0,0 +1,129 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ *
+ * Author P Barber
+ */
+// 8 bit look up tables for gamma or a user curve, for the camera's hardware LUT or applied as frames are copied.
+//
+// A LUT file is text, 256 output values (0-255) for inputs 0 to 255, separated by white space or commas.
+// Lines starting with # are comments.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gstueyelut.h"
+
+// Gamma as the SDK defines it, values above 1 brighten the mid tones
+void
+gst_ueye_lut_make_gamma (guint8 * table, gdouble gamma)
+{
+	gint i;
+
+	for (i = 0; i < GST_UEYE_LUT_SIZE; i++)
+		table[i] = (guint8) CLAMP (floor (255.0 * pow (i / 255.0, 1.0 / gamma) + 0.5), 0, 255);
+}
+
+gboolean
+gst_ueye_lut_load_file (guint8 * table, const gchar * filename, GError ** error)
+{
+	gchar *contents, **lines, **line;
+	gint n = 0;
+
+	if (!g_file_get_contents (filename, &contents, NULL, error))
+		return FALSE;
+
+	lines = g_strsplit (contents, "\n", -1);
+	for (line = lines; *line != NULL && n <= GST_UEYE_LUT_SIZE; line++) {
+		gchar *p = g_strstrip (*line), *end;
+
+		if (*p == '#')
+			continue;
+		while (*p != '\0') {
+			glong value;
+
+			while (*p == ',' || g_ascii_isspace (*p))
+				p++;
+			if (*p == '\0')
+				break;
+			value = strtol (p, &end, 0);
+			if (end == p || value < 0 || value > 255 || n >= GST_UEYE_LUT_SIZE) {
+				n = GST_UEYE_LUT_SIZE + 1;  // not a table we can use
+				break;
+			}
+			table[n++] = (guint8) value;
+			p = end;
+		}
+	}
+	g_strfreev (lines);
+	g_free (contents);
+
+	if (n != GST_UEYE_LUT_SIZE) {
+		g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+				"%s is not a LUT of %d values from 0 to 255", filename, GST_UEYE_LUT_SIZE);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+// The camera LUT has 64 points on each channel, scaled 0 to 1
+void
+gst_ueye_lut_to_config (const guint8 * table, IS_LUT_CONFIGURATION_64 * config)
+{
+	gint i, c;
+
+	memset (config, 0, sizeof (*config));
+	for (i = 0; i < IS_LUT_64; i++) {
+		gdouble value = table[i * (GST_UEYE_LUT_SIZE - 1) / (IS_LUT_64 - 1)] / 255.0;
+
+		for (c = 0; c < 3; c++)
+			config->dblValues[c][i] = value;
+	}
+	config->bAllChannelsAreEqual = TRUE;
+}
+
+// Look up n bytes through the table, dest may be src.
+// A byte table lookup does not vectorise (SSE and NEON shuffles index 16 entries, not 256),
+// so this is done in the copy loop, 8 pixels a word, and costs no extra pass over the frame.
+void
+gst_ueye_lut_apply (guint8 * dest, const guint8 * src, gsize n, const guint8 * table)
+{
+	gsize i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		guint64 in, out;
+
+		memcpy (&in, src + i, 8);
+		out = (guint64) table[in & 0xff]
+				| ((guint64) table[(in >> 8) & 0xff] << 8)
+				| ((guint64) table[(in >> 16) & 0xff] << 16)
+				| ((guint64) table[(in >> 24) & 0xff] << 24)
+				| ((guint64) table[(in >> 32) & 0xff] << 32)
+				| ((guint64) table[(in >> 40) & 0xff] << 40)
+				| ((guint64) table[(in >> 48) & 0xff] << 48)
+				| ((guint64) table[in >> 56] << 56);
+		memcpy (dest + i, &out, 8);
+	}
+	for (; i < n; i++)
+		dest[i] = table[src[i]];
+}
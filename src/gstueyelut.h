@@ -0,0 +1,47 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _GST_UEYE_LUT_H_
+#define _GST_UEYE_LUT_H_
+
+#include <gst/gst.h>
+
+#include  <ueye.h>
+
+G_BEGIN_DECLS
+
+#define GST_UEYE_LUT_SIZE 256  // 8 bit in, 8 bit out
+
+// Where the curve is applied
+typedef enum
+{
+  GST_UEYE_LUT_NONE,  // gamma 1.0 and no LUT file, the pixels are untouched
+  GST_UEYE_LUT_HARDWARE,  // the camera's LUT
+  GST_UEYE_LUT_SOFTWARE,  // our table, applied as frames are copied
+  GST_UEYE_LUT_SDK  // SDK software gamma, for formats our table cannot apply to
+} GstUEyeLutMode;
+
+void gst_ueye_lut_make_gamma (guint8 * table, gdouble gamma);
+gboolean gst_ueye_lut_load_file (guint8 * table, const gchar * filename, GError ** error);
+void gst_ueye_lut_to_config (const guint8 * table, IS_LUT_CONFIGURATION_64 * config);
+void gst_ueye_lut_apply (guint8 * dest, const guint8 * src, gsize n, const guint8 * table);
+
+G_END_DECLS
+
+#endif
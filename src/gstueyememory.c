@@ -0,0 +1,246 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ *
+ * Author P Barber
+ */
+// Allocator for the ring of SDK sequence memories, so that a frame locked by the image queue
+// can be pushed downstream as it is and handed back to the driver when the last reference goes.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstueyememory.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_ueye_memory_debug);
+#define GST_CAT_DEFAULT gst_ueye_memory_debug
+
+#define UEYE_MEMORY_ALIGN 64  // bytes, suits any SIMD processing downstream
+
+G_DEFINE_TYPE (GstUEyeAllocator, gst_ueye_allocator, GST_TYPE_ALLOCATOR);
+
+static GstMemory *
+gst_ueye_allocator_alloc (GstAllocator * allocator, gsize size, GstAllocationParams * params)
+{
+	// Memories only come from the camera via gst_ueye_allocator_wrap
+	GST_WARNING_OBJECT (allocator, "The uEye allocator cannot allocate on request.");
+	return NULL;
+}
+
+static void
+gst_ueye_allocator_free (GstAllocator * allocator, GstMemory * mem)
+{
+	GstUEyeAllocator *ualloc = GST_UEYE_ALLOCATOR (allocator);
+	GstUEyeMemory *umem = (GstUEyeMemory *) mem;
+
+	g_mutex_lock (&ualloc->lock);
+	// Hand the image memory back to the ring, unless the camera is already finished with it
+	if (ualloc->active)
+		is_UnlockSeqBuf(ualloc->hCam, ualloc->lSeqMemId[umem->index], ualloc->pcSeqImgMem[umem->index]);
+	ualloc->outstanding--;
+	g_mutex_unlock (&ualloc->lock);
+
+	g_slice_free (GstUEyeMemory, umem);
+}
+
+static gpointer
+gst_ueye_memory_map (GstMemory * mem, gsize maxsize, GstMapFlags flags)
+{
+	GstUEyeAllocator *ualloc = GST_UEYE_ALLOCATOR (mem->allocator);
+
+	return ualloc->pcSeqImgMem[((GstUEyeMemory *) mem)->index];
+}
+
+static void
+gst_ueye_memory_unmap (GstMemory * mem)
+{
+}
+
+static GstMemory *
+gst_ueye_memory_share (GstMemory * mem, gssize offset, gssize size)
+{
+	// Not shareable (GST_MEMORY_FLAG_NO_SHARE), callers copy instead
+	return NULL;
+}
+
+static void
+gst_ueye_allocator_finalize (GObject * object)
+{
+	GstUEyeAllocator *ualloc = GST_UEYE_ALLOCATOR (object);
+	gint i;
+
+	GST_DEBUG_OBJECT (ualloc, "finalize");
+
+	// All GstMemory hold a ref on us, so nothing can still be using the image memories
+	for (i = 0; i < ualloc->nBuffers; i++)
+		g_free (ualloc->pSeqAlloc[i]);
+	g_free (ualloc->pSeqAlloc);
+	g_free (ualloc->pcSeqImgMem);
+	g_free (ualloc->lSeqMemId);
+	g_mutex_clear (&ualloc->lock);
+
+	G_OBJECT_CLASS (gst_ueye_allocator_parent_class)->finalize (object);
+}
+
+static void
+gst_ueye_allocator_class_init (GstUEyeAllocatorClass * klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+	GstAllocatorClass *allocator_class = GST_ALLOCATOR_CLASS (klass);
+
+	GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "ueyememory", 0,
+			"uEye sequence memory");
+
+	gobject_class->finalize = gst_ueye_allocator_finalize;
+
+	allocator_class->alloc = gst_ueye_allocator_alloc;
+	allocator_class->free = gst_ueye_allocator_free;
+}
+
+static void
+gst_ueye_allocator_init (GstUEyeAllocator * ualloc)
+{
+	GstAllocator *allocator = GST_ALLOCATOR_CAST (ualloc);
+
+	allocator->mem_type = GST_UEYE_MEMORY_TYPE;
+	allocator->mem_map = gst_ueye_memory_map;
+	allocator->mem_unmap = gst_ueye_memory_unmap;
+	allocator->mem_share = gst_ueye_memory_share;
+
+	GST_OBJECT_FLAG_SET (allocator, GST_ALLOCATOR_FLAG_CUSTOM_ALLOC);
+
+	g_mutex_init (&ualloc->lock);
+	ualloc->hCam = 0;
+	ualloc->active = FALSE;
+	ualloc->nBuffers = 0;
+	ualloc->pcSeqImgMem = NULL;
+	ualloc->pSeqAlloc = NULL;
+	ualloc->lSeqMemId = NULL;
+	ualloc->nBufferSize = 0;
+	ualloc->outstanding = 0;
+}
+
+// Allocate nBuffers image memories and add them to the camera's sequence.
+// Returns NULL if fewer than 2 could be set up, one being written by the camera while we read the other.
+GstUEyeAllocator *
+gst_ueye_allocator_new (HIDS hCam, INT nWidth, INT nHeight, INT nBitsPerPixel, gint nBuffers)
+{
+	GstUEyeAllocator *ualloc;
+	gsize line;
+	gint i;
+
+	ualloc = g_object_new (GST_TYPE_UEYE_ALLOCATOR, NULL);
+	ualloc->hCam = hCam;
+
+	// The SDK wants lines padded to a multiple of 4 bytes
+	line = GST_ROUND_UP_4 ((nWidth * nBitsPerPixel + 7) / 8);
+	ualloc->nBufferSize = line * nHeight;
+
+	ualloc->pcSeqImgMem = g_new0 (char *, nBuffers);
+	ualloc->pSeqAlloc = g_new0 (gpointer, nBuffers);
+	ualloc->lSeqMemId = g_new0 (INT, nBuffers);
+
+	GST_DEBUG_OBJECT (ualloc, "Allocating %d sequence buffers of %" G_GSIZE_FORMAT " bytes", nBuffers, ualloc->nBufferSize);
+	for (i = 0; i < nBuffers; i++) {
+		gpointer mem = g_malloc (ualloc->nBufferSize + UEYE_MEMORY_ALIGN - 1);
+		char *pcMem = (char *) GST_ROUND_UP_N ((gsize) mem, UEYE_MEMORY_ALIGN);
+
+		if (is_SetAllocatedImageMem(hCam, nWidth, nHeight, nBitsPerPixel, pcMem, &(ualloc->lSeqMemId[i])) != IS_SUCCESS){
+			g_free (mem);
+			break;
+		}
+		if (is_AddToSequence(hCam, pcMem, ualloc->lSeqMemId[i]) != IS_SUCCESS){
+			is_FreeImageMem(hCam, pcMem, ualloc->lSeqMemId[i]);
+			g_free (mem);
+			break;
+		}
+		ualloc->pSeqAlloc[i] = mem;
+		ualloc->pcSeqImgMem[i] = pcMem;
+		ualloc->nBuffers++;
+	}
+	ualloc->active = TRUE;
+
+	if (ualloc->nBuffers < 2){
+		GST_ERROR_OBJECT (ualloc, "Could only allocate %d of %d sequence buffers.", ualloc->nBuffers, nBuffers);
+		gst_ueye_allocator_release_sequence (ualloc);
+		gst_object_unref (ualloc);
+		return NULL;
+	}
+	if (ualloc->nBuffers < nBuffers)
+		GST_WARNING_OBJECT (ualloc, "Only allocated %d of %d sequence buffers.", ualloc->nBuffers, nBuffers);
+
+	return ualloc;
+}
+
+// Wrap a memory returned locked by is_WaitForNextImage, it is unlocked when the GstMemory is freed
+GstMemory *
+gst_ueye_allocator_wrap (GstUEyeAllocator * ualloc, char *pcMem, INT nMemId, gsize size)
+{
+	GstUEyeMemory *umem;
+	gint i;
+
+	for (i = 0; i < ualloc->nBuffers; i++)
+		if (ualloc->lSeqMemId[i] == nMemId)
+			break;
+	if (G_UNLIKELY (i == ualloc->nBuffers || ualloc->pcSeqImgMem[i] != pcMem)){
+		GST_ERROR_OBJECT (ualloc, "Image memory %d is not in the sequence.", nMemId);
+		return NULL;
+	}
+
+	umem = g_slice_new (GstUEyeMemory);
+	gst_memory_init (GST_MEMORY_CAST (umem), GST_MEMORY_FLAG_NO_SHARE, GST_ALLOCATOR_CAST (ualloc),
+			NULL, ualloc->nBufferSize, UEYE_MEMORY_ALIGN - 1, 0, size);
+	umem->index = i;
+
+	g_mutex_lock (&ualloc->lock);
+	ualloc->outstanding++;
+	g_mutex_unlock (&ualloc->lock);
+
+	return GST_MEMORY_CAST (umem);
+}
+
+gint
+gst_ueye_allocator_get_outstanding (GstUEyeAllocator * ualloc)
+{
+	gint outstanding;
+
+	g_mutex_lock (&ualloc->lock);
+	outstanding = ualloc->outstanding;
+	g_mutex_unlock (&ualloc->lock);
+
+	return outstanding;
+}
+
+// Take the memories out of the SDK's hands, call with the image queue already exited.
+// Memories still downstream stay valid until they are freed, they are just not unlocked any more.
+void
+gst_ueye_allocator_release_sequence (GstUEyeAllocator * ualloc)
+{
+	gint i;
+
+	g_mutex_lock (&ualloc->lock);
+	if (ualloc->active){
+		GST_DEBUG_OBJECT (ualloc, "Releasing sequence, %d buffers still downstream", ualloc->outstanding);
+		is_ClearSequence(ualloc->hCam);
+		// For is_SetAllocatedImageMem memory this only removes it from the driver's management
+		for (i = 0; i < ualloc->nBuffers; i++)
+			is_FreeImageMem(ualloc->hCam, ualloc->pcSeqImgMem[i], ualloc->lSeqMemId[i]);
+		ualloc->active = FALSE;
+	}
+	g_mutex_unlock (&ualloc->lock);
+}
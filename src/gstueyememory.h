@@ -0,0 +1,82 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _GST_UEYE_MEMORY_H_
+#define _GST_UEYE_MEMORY_H_
+
+#include <gst/gst.h>
+
+#include  <ueye.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_UEYE_ALLOCATOR   (gst_ueye_allocator_get_type())
+#define GST_UEYE_ALLOCATOR(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_UEYE_ALLOCATOR,GstUEyeAllocator))
+#define GST_IS_UEYE_ALLOCATOR(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_UEYE_ALLOCATOR))
+
+#define GST_UEYE_MEMORY_TYPE "uEyeSequenceMemory"
+
+typedef struct _GstUEyeAllocator GstUEyeAllocator;
+typedef struct _GstUEyeAllocatorClass GstUEyeAllocatorClass;
+typedef struct _GstUEyeMemory GstUEyeMemory;
+
+// A GstMemory wrapping one image memory of the SDK sequence.
+// The image memory stays locked by the image queue until the GstMemory is freed.
+struct _GstUEyeMemory
+{
+  GstMemory mem;
+
+  gint index;  // slot in the allocator's ring
+};
+
+// Owns the ring of image memories the camera captures into.
+// The memories are allocated here and registered with the SDK (is_SetAllocatedImageMem), so they
+// outlive is_ExitCamera until the last GstMemory wrapping them is gone.
+struct _GstUEyeAllocator
+{
+  GstAllocator parent;
+
+  HIDS hCam;
+  GMutex lock;
+  gboolean active;  // FALSE once the sequence is released, memories are then no longer unlocked in the SDK
+
+  gint nBuffers;
+  char **pcSeqImgMem;  // aligned pointers handed to the SDK
+  gpointer *pSeqAlloc;  // what we got from g_malloc, to free
+  INT *lSeqMemId;
+  gsize nBufferSize;
+
+  gint outstanding;  // ring memories currently wrapped in GstMemory (i.e. downstream)
+};
+
+struct _GstUEyeAllocatorClass
+{
+  GstAllocatorClass parent_class;
+};
+
+GType gst_ueye_allocator_get_type (void);
+
+GstUEyeAllocator *gst_ueye_allocator_new (HIDS hCam, INT nWidth, INT nHeight, INT nBitsPerPixel, gint nBuffers);
+GstMemory *gst_ueye_allocator_wrap (GstUEyeAllocator * allocator, char *pcMem, INT nMemId, gsize size);
+gint gst_ueye_allocator_get_outstanding (GstUEyeAllocator * allocator);
+void gst_ueye_allocator_release_sequence (GstUEyeAllocator * allocator);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,162 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ *
+ * Author P Barber
+ */
+// Per frame timing meta, see gstueyetracer.c for the tracer that collects it,
+// and frame statistics meta, see gstueyestats.c
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstueyemeta.h"
+
+GType
+gst_ueye_timing_meta_api_get_type (void)
+{
+	static volatile GType type;
+	static const gchar *tags[] = { NULL };
+
+	if (g_once_init_enter (&type)) {
+		GType _type = gst_meta_api_type_register ("GstUEyeTimingMetaAPI", tags);
+		g_once_init_leave (&type, _type);
+	}
+	return type;
+}
+
+static gboolean
+gst_ueye_timing_meta_init (GstMeta * meta, gpointer params, GstBuffer * buffer)
+{
+	GstUEyeTimingMeta *tmeta = (GstUEyeTimingMeta *) meta;
+
+	tmeta->device = GST_CLOCK_TIME_NONE;
+	tmeta->driver = GST_CLOCK_TIME_NONE;
+	tmeta->wait = GST_CLOCK_TIME_NONE;
+	tmeta->dequeue = GST_CLOCK_TIME_NONE;
+	tmeta->copy_start = GST_CLOCK_TIME_NONE;
+	tmeta->copy_end = GST_CLOCK_TIME_NONE;
+	tmeta->push = GST_CLOCK_TIME_NONE;
+
+	return TRUE;
+}
+
+// The times stay with the frame when the buffer is copied, they do not apply to parts of it
+static gboolean
+gst_ueye_timing_meta_transform (GstBuffer * dest, GstMeta * meta, GstBuffer * buffer, GQuark type, gpointer data)
+{
+	GstUEyeTimingMeta *smeta = (GstUEyeTimingMeta *) meta, *dmeta;
+
+	if (!GST_META_TRANSFORM_IS_COPY (type))
+		return FALSE;
+
+	dmeta = gst_buffer_add_ueye_timing_meta (dest);
+	if (dmeta == NULL)
+		return FALSE;
+
+	dmeta->device = smeta->device;
+	dmeta->driver = smeta->driver;
+	dmeta->wait = smeta->wait;
+	dmeta->dequeue = smeta->dequeue;
+	dmeta->copy_start = smeta->copy_start;
+	dmeta->copy_end = smeta->copy_end;
+	dmeta->push = smeta->push;
+
+	return TRUE;
+}
+
+const GstMetaInfo *
+gst_ueye_timing_meta_get_info (void)
+{
+	static const GstMetaInfo *meta_info = NULL;
+
+	if (g_once_init_enter ((GstMetaInfo **) & meta_info)) {
+		const GstMetaInfo *mi = gst_meta_register (GST_UEYE_TIMING_META_API_TYPE, "GstUEyeTimingMeta",
+				sizeof (GstUEyeTimingMeta), gst_ueye_timing_meta_init, NULL, gst_ueye_timing_meta_transform);
+		g_once_init_leave ((GstMetaInfo **) & meta_info, (GstMetaInfo *) mi);
+	}
+	return meta_info;
+}
+
+GstUEyeTimingMeta *
+gst_buffer_add_ueye_timing_meta (GstBuffer * buffer)
+{
+	return (GstUEyeTimingMeta *) gst_buffer_add_meta (buffer, GST_UEYE_TIMING_META_INFO, NULL);
+}
+
+GType
+gst_ueye_stats_meta_api_get_type (void)
+{
+	static volatile GType type;
+	static const gchar *tags[] = { NULL };
+
+	if (g_once_init_enter (&type)) {
+		GType _type = gst_meta_api_type_register ("GstUEyeStatsMetaAPI", tags);
+		g_once_init_leave (&type, _type);
+	}
+	return type;
+}
+
+static gboolean
+gst_ueye_stats_meta_init (GstMeta * meta, gpointer params, GstBuffer * buffer)
+{
+	GstUEyeStatsMeta *smeta = (GstUEyeStatsMeta *) meta;
+
+	memset (&smeta->stats, 0, sizeof (smeta->stats));
+
+	return TRUE;
+}
+
+// Like the times, the statistics are of the whole frame
+static gboolean
+gst_ueye_stats_meta_transform (GstBuffer * dest, GstMeta * meta, GstBuffer * buffer, GQuark type, gpointer data)
+{
+	GstUEyeStatsMeta *smeta = (GstUEyeStatsMeta *) meta, *dmeta;
+
+	if (!GST_META_TRANSFORM_IS_COPY (type))
+		return FALSE;
+
+	dmeta = gst_buffer_add_ueye_stats_meta (dest);
+	if (dmeta == NULL)
+		return FALSE;
+
+	dmeta->stats = smeta->stats;
+
+	return TRUE;
+}
+
+const GstMetaInfo *
+gst_ueye_stats_meta_get_info (void)
+{
+	static const GstMetaInfo *meta_info = NULL;
+
+	if (g_once_init_enter ((GstMetaInfo **) & meta_info)) {
+		const GstMetaInfo *mi = gst_meta_register (GST_UEYE_STATS_META_API_TYPE, "GstUEyeStatsMeta",
+				sizeof (GstUEyeStatsMeta), gst_ueye_stats_meta_init, NULL, gst_ueye_stats_meta_transform);
+		g_once_init_leave ((GstMetaInfo **) & meta_info, (GstMetaInfo *) mi);
+	}
+	return meta_info;
+}
+
+GstUEyeStatsMeta *
+gst_buffer_add_ueye_stats_meta (GstBuffer * buffer)
+{
+	return (GstUEyeStatsMeta *) gst_buffer_add_meta (buffer, GST_UEYE_STATS_META_INFO, NULL);
+}
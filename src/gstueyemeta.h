@@ -0,0 +1,99 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _GST_UEYE_META_H_
+#define _GST_UEYE_META_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_UEYE_TIMING_META_API_TYPE (gst_ueye_timing_meta_api_get_type())
+#define GST_UEYE_TIMING_META_INFO  (gst_ueye_timing_meta_get_info())
+#define gst_buffer_get_ueye_timing_meta(b) \
+  ((GstUEyeTimingMeta*)gst_buffer_get_meta((b),GST_UEYE_TIMING_META_API_TYPE))
+
+typedef struct _GstUEyeTimingMeta GstUEyeTimingMeta;
+
+#define GST_UEYE_STATS_META_API_TYPE (gst_ueye_stats_meta_api_get_type())
+#define GST_UEYE_STATS_META_INFO  (gst_ueye_stats_meta_get_info())
+#define gst_buffer_get_ueye_stats_meta(b) \
+  ((GstUEyeStatsMeta*)gst_buffer_get_meta((b),GST_UEYE_STATS_META_API_TYPE))
+
+#define GST_UEYE_STATS_BINS 256  // histograms of the top 8 bits of each sample
+#define GST_UEYE_STATS_MAX_CHANNELS 3
+
+typedef struct _GstUEyeStatsChannel GstUEyeStatsChannel;
+typedef struct _GstUEyeStats GstUEyeStats;
+typedef struct _GstUEyeStatsMeta GstUEyeStatsMeta;
+
+// Where a frame was on its way from the sensor to the pipeline.
+// device is the camera's clock, the rest are the monotonic clock (gst_util_get_timestamp), GST_CLOCK_TIME_NONE if not known.
+struct _GstUEyeTimingMeta
+{
+  GstMeta meta;
+
+  GstClockTime device;  // camera's timestamp for the exposure
+  GstClockTime driver;  // driver received the frame, from the SDK's system time (1 ms resolution)
+  GstClockTime wait;  // is_WaitForNextImage returned it to the capture thread
+  GstClockTime dequeue;  // create took it from the capture queue
+  GstClockTime copy_start;  // copy into a pipeline buffer, NONE if the ring memory was pushed
+  GstClockTime copy_end;
+  GstClockTime push;  // create returned it, to be pushed
+};
+
+// One channel of a frame, from the samples on a grid
+struct _GstUEyeStatsChannel
+{
+  guint32 histogram[GST_UEYE_STATS_BINS];
+  guint min;
+  guint max;
+  guint64 sum;
+  guint count;  // samples taken
+  guint saturated;  // samples at the top code
+};
+
+// Statistics of a frame as it is pushed, grey (or the luma of UYVY) in channel 0, or red, green and blue.
+// Samples are as pushed, 0-255 or 0-65535 for 16 bit formats.
+struct _GstUEyeStats
+{
+  guint n_channels;
+  guint step;  // the grid, every step'th pixel of every step'th row
+  guint saturation;  // the top code for the format and its bit depth
+  GstUEyeStatsChannel channel[GST_UEYE_STATS_MAX_CHANNELS];
+};
+
+struct _GstUEyeStatsMeta
+{
+  GstMeta meta;
+
+  GstUEyeStats stats;
+};
+
+GType gst_ueye_timing_meta_api_get_type (void);
+const GstMetaInfo *gst_ueye_timing_meta_get_info (void);
+GstUEyeTimingMeta *gst_buffer_add_ueye_timing_meta (GstBuffer * buffer);
+
+GType gst_ueye_stats_meta_api_get_type (void);
+const GstMetaInfo *gst_ueye_stats_meta_get_info (void);
+GstUEyeStatsMeta *gst_buffer_add_ueye_stats_meta (GstBuffer * buffer);
+
+G_END_DECLS
+
+#endif
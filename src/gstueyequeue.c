@@ -0,0 +1,201 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ *
+ * Author P Barber
+ */
+// Single producer, single consumer queue of locked SDK frames, between the capture thread and create.
+// Pushing and popping are atomic updates of head and tail, no lock is taken while frames flow.
+// To drop the oldest frame the producer takes it off the head, racing the consumer with a
+// compare and exchange: whoever loses sees head has moved and tries again. A consumer that copied
+// a slot the producer was overwriting loses that race, so never uses the torn copy.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstueyequeue.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_ueye_queue_debug);
+#define GST_CAT_DEFAULT gst_ueye_queue_debug
+
+#define QUEUE_NEXT(i) ((gint) ((guint) (i) + 1))
+
+GstUEyeQueue *
+gst_ueye_queue_new (guint capacity)
+{
+	GstUEyeQueue *queue;
+	guint slots = 1;
+
+	GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "ueyequeue", 0,
+			"debug category for uEye frame queue");
+
+	capacity = MAX (capacity, 1);
+	while (slots < capacity)
+		slots <<= 1;
+
+	queue = g_new0 (GstUEyeQueue, 1);
+	queue->frames = g_new0 (GstUEyeFrame, slots);
+	queue->capacity = capacity;
+	queue->mask = slots - 1;
+	g_mutex_init (&queue->lock);
+	g_cond_init (&queue->cond);
+
+	GST_DEBUG ("New queue of %u frames", capacity);
+
+	return queue;
+}
+
+void
+gst_ueye_queue_free (GstUEyeQueue * queue)
+{
+	g_mutex_clear (&queue->lock);
+	g_cond_clear (&queue->cond);
+	g_free (queue->frames);
+	g_free (queue);
+}
+
+guint
+gst_ueye_queue_get_depth (GstUEyeQueue * queue)
+{
+	// Read head first, tail can only have moved further on
+	gint head = g_atomic_int_get (&queue->head);
+	gint tail = g_atomic_int_get (&queue->tail);
+
+	return (guint) tail - (guint) head;
+}
+
+// Wake the other thread, only if it is asleep. Both sides change the queue before reading waiting,
+// and set waiting before looking at the queue, so one of them always sees the other.
+static void
+gst_ueye_queue_wake (GstUEyeQueue * queue)
+{
+	if (g_atomic_int_get (&queue->waiting)) {
+		g_mutex_lock (&queue->lock);
+		g_cond_broadcast (&queue->cond);
+		g_mutex_unlock (&queue->lock);
+	}
+}
+
+gboolean
+gst_ueye_queue_try_pop (GstUEyeQueue * queue, GstUEyeFrame * frame)
+{
+	gint head;
+
+	do {
+		head = g_atomic_int_get (&queue->head);
+		if (head == g_atomic_int_get (&queue->tail))
+			return FALSE;
+		*frame = queue->frames[(guint) head & queue->mask];
+	} while (!g_atomic_int_compare_and_exchange (&queue->head, head, QUEUE_NEXT (head)));
+
+	frame->queue_dropped = g_atomic_int_and (&queue->dropped, 0);
+
+	gst_ueye_queue_wake (queue);
+
+	return TRUE;
+}
+
+// Pop the oldest frame, waiting until end_time (monotonic) for one to arrive
+GstUEyeQueueResult
+gst_ueye_queue_pop (GstUEyeQueue * queue, GstUEyeFrame * frame, gint64 end_time)
+{
+	gboolean timed_out = FALSE;
+
+	for (;;) {
+		if (g_atomic_int_get (&queue->flushing))
+			return GST_UEYE_QUEUE_FLUSHING;
+		if (gst_ueye_queue_try_pop (queue, frame))
+			return GST_UEYE_QUEUE_OK;
+		if (timed_out)
+			return GST_UEYE_QUEUE_TIMEOUT;
+
+		g_mutex_lock (&queue->lock);
+		g_atomic_int_inc (&queue->waiting);
+		while (gst_ueye_queue_get_depth (queue) == 0 && !g_atomic_int_get (&queue->flushing)) {
+			if (!g_cond_wait_until (&queue->cond, &queue->lock, end_time)) {
+				timed_out = TRUE;
+				break;
+			}
+		}
+		g_atomic_int_add (&queue->waiting, -1);
+		g_mutex_unlock (&queue->lock);
+	}
+}
+
+// Queue a frame, from the capture thread. If the queue is full the policy decides which frame is dropped,
+// or waits for space. A dropped frame is returned in dropped, for the caller to give back to the SDK.
+GstUEyeQueueResult
+gst_ueye_queue_push (GstUEyeQueue * queue, const GstUEyeFrame * frame,
+		GstUEyeOverflowPolicy policy, GstUEyeFrame * dropped)
+{
+	GstUEyeQueueResult ret = GST_UEYE_QUEUE_OK;
+	gint tail = g_atomic_int_get (&queue->tail);  // only we change tail
+	gint head;
+
+	if (g_atomic_int_get (&queue->flushing))
+		return GST_UEYE_QUEUE_FLUSHING;
+
+	for (;;) {
+		head = g_atomic_int_get (&queue->head);
+		if ((guint) tail - (guint) head < queue->capacity)
+			break;
+
+		switch (policy) {
+		case GST_UEYE_OVERFLOW_DROP_OLDEST:
+			*dropped = queue->frames[(guint) head & queue->mask];
+			if (g_atomic_int_compare_and_exchange (&queue->head, head, QUEUE_NEXT (head))) {
+				g_atomic_int_inc ((volatile gint *) &queue->dropped);
+				ret = GST_UEYE_QUEUE_DROPPED;
+			}
+			// otherwise create took it, so there is space now
+			break;
+		case GST_UEYE_OVERFLOW_DROP_NEWEST:
+			*dropped = *frame;
+			g_atomic_int_inc ((volatile gint *) &queue->dropped);
+			return GST_UEYE_QUEUE_DROPPED;
+		case GST_UEYE_OVERFLOW_BLOCK:
+		default:
+			g_mutex_lock (&queue->lock);
+			g_atomic_int_inc (&queue->waiting);
+			while (gst_ueye_queue_get_depth (queue) >= queue->capacity && !g_atomic_int_get (&queue->flushing))
+				g_cond_wait (&queue->cond, &queue->lock);
+			g_atomic_int_add (&queue->waiting, -1);
+			g_mutex_unlock (&queue->lock);
+			if (g_atomic_int_get (&queue->flushing))
+				return GST_UEYE_QUEUE_FLUSHING;
+			break;
+		}
+	}
+
+	queue->frames[(guint) tail & queue->mask] = *frame;
+	g_atomic_int_set (&queue->tail, QUEUE_NEXT (tail));
+
+	gst_ueye_queue_wake (queue);
+
+	return ret;
+}
+
+void
+gst_ueye_queue_set_flushing (GstUEyeQueue * queue, gboolean flushing)
+{
+	g_atomic_int_set (&queue->flushing, flushing);
+
+	g_mutex_lock (&queue->lock);
+	g_cond_broadcast (&queue->cond);
+	g_mutex_unlock (&queue->lock);
+}
@@ -0,0 +1,87 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _GST_UEYE_QUEUE_H_
+#define _GST_UEYE_QUEUE_H_
+
+#include <gst/gst.h>
+
+#include  <ueye.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstUEyeFrame GstUEyeFrame;
+typedef struct _GstUEyeQueue GstUEyeQueue;
+
+// A frame locked in the SDK ring, as returned by the image queue
+struct _GstUEyeFrame
+{
+  char *pcMem;
+  INT nMemId;
+  UEYEIMAGEINFO info;  // u64TimestampDevice is 0 if the driver could not tell us
+  GstClockTime arrival;  // running time the frame was dequeued
+  GstClockTime wait_time;  // monotonic time the frame was dequeued, for the timing meta
+  guint queue_dropped;  // frames the queue dropped since the last one popped
+};
+
+// What the capture thread does with a frame when the queue is full
+typedef enum
+{
+  GST_UEYE_OVERFLOW_DROP_OLDEST,
+  GST_UEYE_OVERFLOW_DROP_NEWEST,
+  GST_UEYE_OVERFLOW_BLOCK
+} GstUEyeOverflowPolicy;
+
+typedef enum
+{
+  GST_UEYE_QUEUE_OK,
+  GST_UEYE_QUEUE_DROPPED,  // a frame was dropped, it is returned to the caller to unlock
+  GST_UEYE_QUEUE_TIMEOUT,
+  GST_UEYE_QUEUE_FLUSHING
+} GstUEyeQueueResult;
+
+// Bounded queue of frames from the capture thread (producer) to the streaming thread (consumer).
+// head and tail only ever increase, the producer also advances head when it drops the oldest frame.
+// The mutex and cond are only used to sleep when the queue is empty (or full when blocking).
+struct _GstUEyeQueue
+{
+  GstUEyeFrame *frames;
+  guint capacity;  // frames the queue holds
+  guint mask;  // slots - 1, the slots are a power of two so the counters can wrap
+  volatile gint head;  // next frame to pop
+  volatile gint tail;  // next slot to fill
+  volatile guint dropped;  // frames dropped since the last pop
+  volatile gint waiting;  // threads asleep on cond
+  volatile gint flushing;
+  GMutex lock;
+  GCond cond;
+};
+
+GstUEyeQueue *gst_ueye_queue_new (guint capacity);
+void gst_ueye_queue_free (GstUEyeQueue * queue);
+GstUEyeQueueResult gst_ueye_queue_push (GstUEyeQueue * queue, const GstUEyeFrame * frame,
+    GstUEyeOverflowPolicy policy, GstUEyeFrame * dropped);
+GstUEyeQueueResult gst_ueye_queue_pop (GstUEyeQueue * queue, GstUEyeFrame * frame, gint64 end_time);
+gboolean gst_ueye_queue_try_pop (GstUEyeQueue * queue, GstUEyeFrame * frame);
+guint gst_ueye_queue_get_depth (GstUEyeQueue * queue);
+void gst_ueye_queue_set_flushing (GstUEyeQueue * queue, gboolean flushing);
+
+G_END_DECLS
+
+#endif
@@ -33,11 +33,17 @@
  */
 
 // Which functions of the base class to override. Create must alloc and fill the buffer. Fill just needs to fill it
-//#define OVERRIDE_FILL  !!! NOT IMPLEMENTED !!!
+// With both, create pushes the SDK ring memory itself where it can, otherwise it allocs a buffer from the pool and calls fill
+#define OVERRIDE_FILL
 #define OVERRIDE_CREATE
 
+#if defined(OVERRIDE_CREATE) && !defined(OVERRIDE_FILL)
+#error "create copies a frame with fill"
+#endif
+
 #include <unistd.h> // for usleep
 #include <string.h> // for memcpy
+#include <math.h>
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -50,6 +56,9 @@
 #include "ueye.h"
 
 #include "gstueyesrc.h"
+#include "gstueyebufferpool.h"
+#include "gstueyedeviceprovider.h"
+#include "gstueyemeta.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_ueye_src_debug);
 #define GST_CAT_DEFAULT gst_ueye_src_debug
@@ -62,10 +71,18 @@ static void gst_ueye_src_get_property (GObject * object,
 static void gst_ueye_src_dispose (GObject * object);
 static void gst_ueye_src_finalize (GObject * object);
 
+static GstStateChangeReturn gst_ueye_src_change_state (GstElement * element, GstStateChange transition);
+
 static gboolean gst_ueye_src_start (GstBaseSrc * src);
 static gboolean gst_ueye_src_stop (GstBaseSrc * src);
+static gboolean gst_ueye_src_unlock (GstBaseSrc * src);
+static gboolean gst_ueye_src_unlock_stop (GstBaseSrc * src);
 static GstCaps *gst_ueye_src_get_caps (GstBaseSrc * src, GstCaps * filter);
 static gboolean gst_ueye_src_set_caps (GstBaseSrc * src, GstCaps * caps);
+static gboolean gst_ueye_src_decide_allocation (GstBaseSrc * src, GstQuery * query);
+static gboolean gst_ueye_src_query (GstBaseSrc * src, GstQuery * query);
+static gboolean gst_ueye_src_negotiate (GstBaseSrc * src);
+static GstCaps *gst_ueye_src_fixate (GstBaseSrc * src, GstCaps * caps);
 
 #ifdef OVERRIDE_CREATE
 	static GstFlowReturn gst_ueye_src_create (GstPushSrc * src, GstBuffer ** buf);
@@ -76,6 +93,22 @@ static gboolean gst_ueye_src_set_caps (GstBaseSrc * src, GstCaps * caps);
 
 //static GstCaps *gst_ueye_src_create_caps (GstUEyeSrc * src);
 static void gst_ueye_src_reset (GstUEyeSrc * src);
+static gboolean gst_ueye_src_trigger (GstUEyeSrc * src);
+static void gst_ueye_src_apply_parameters (GstUEyeSrc * src);
+static void gst_ueye_src_check_latency (GstUEyeSrc * src);
+static gboolean gst_ueye_src_refresh (GstUEyeSrc * src);
+static void gst_ueye_src_start_capture (GstUEyeSrc * src);
+static void gst_ueye_src_stop_capture (GstUEyeSrc * src);
+static gboolean gst_ueye_src_join_open (GstUEyeSrc * src);
+enum
+{
+	SIGNAL_TRIGGER,
+	SIGNAL_REFRESH,
+	LAST_SIGNAL
+};
+
+static guint gst_ueye_src_signals[LAST_SIGNAL] = { 0 };
+
 enum
 {
 	PROP_0,
@@ -91,7 +124,36 @@ enum
 	PROP_HORIZ_FLIP,
 	PROP_VERT_FLIP,
 	PROP_WHITEBALANCE,
-	PROP_MAXFRAMERATE
+	PROP_MAXFRAMERATE,
+	PROP_NUM_BUFFERS_SDK,
+	PROP_DROPPED_FRAMES,
+	PROP_TRANSFER_FAILURES,
+	PROP_TIMEOUTS,
+	PROP_AOI_X,
+	PROP_AOI_Y,
+	PROP_AOI_WIDTH,
+	PROP_AOI_HEIGHT,
+	PROP_DEVICE_ID,
+	PROP_SERIAL,
+	PROP_QUEUE_SIZE,
+	PROP_OVERFLOW_POLICY,
+	PROP_QUEUE_DEPTH,
+	PROP_TRIGGER_MODE,
+	PROP_TRIGGER_TIMEOUT,
+	PROP_PARAMETER_SEQUENCE,
+	PROP_GAMMA,
+	PROP_LUT_FILE,
+	PROP_DEMOSAIC,
+	PROP_DEMOSAIC_THREADS,
+	PROP_SUBSAMPLING,
+	PROP_PARAMETER_SET,
+	PROP_STARTUP_TIME,
+	PROP_RECONNECT_TIMEOUT,
+	PROP_RECONNECTS,
+	PROP_TIMEOUT_RETRIES,
+	PROP_STATISTICS,
+	PROP_STATISTICS_STEP,
+	PROP_STATISTICS_INTERVAL
 };
 
 
@@ -106,23 +168,49 @@ enum
 #define DEFAULT_PROP_GGAIN              0 // 0   // Default values read from the uEye demo program
 #define DEFAULT_PROP_BGAIN              30  // 0 //18   // Default values read from the uEye demo program
 #define DEFAULT_PROP_BINNING            1
+#define DEFAULT_PROP_SUBSAMPLING        1
 #define DEFAULT_PROP_HORIZ_FLIP         0
 #define DEFAULT_PROP_VERT_FLIP          0
 #define DEFAULT_PROP_WHITEBALANCE       GST_WB_DISABLED
 #define DEFAULT_PROP_MAXFRAMERATE       25
+#define DEFAULT_PROP_NUM_BUFFERS_SDK    6
+#define DEFAULT_PROP_AOI_X              0
+#define DEFAULT_PROP_AOI_Y              0
+#define DEFAULT_PROP_AOI_WIDTH          0
+#define DEFAULT_PROP_AOI_HEIGHT         0
+#define DEFAULT_PROP_DEVICE_ID          0
+#define DEFAULT_PROP_SERIAL             NULL
+#define DEFAULT_PROP_QUEUE_SIZE         4
+#define DEFAULT_PROP_OVERFLOW_POLICY    GST_UEYE_OVERFLOW_DROP_OLDEST
+#define DEFAULT_PROP_TRIGGER_MODE       GST_TRIGGER_FREERUN
+#define DEFAULT_PROP_TRIGGER_TIMEOUT    10000
+#define DEFAULT_PROP_GAMMA              1.8
+#define DEFAULT_PROP_LUT_FILE           NULL
+#define DEFAULT_PROP_DEMOSAIC           GST_UEYE_DEMOSAIC_SDK
+#define DEFAULT_PROP_DEMOSAIC_THREADS   0
+#define DEFAULT_PROP_PARAMETER_SET      NULL
+#define DEFAULT_PROP_RECONNECT_TIMEOUT  10000
+#define DEFAULT_PROP_TIMEOUT_RETRIES    0
+#define DEFAULT_PROP_STATISTICS         FALSE
+#define DEFAULT_PROP_STATISTICS_STEP    8
+#define DEFAULT_PROP_STATISTICS_INTERVAL 100
 
 #define UEYE_REQUIRED_SYNC_PULSE_WIDTH 1   // in ms
+#define UEYE_FRAMERATE_TOLERANCE 0.001   // a fixed frame rate from caps must be programmed this closely
 
-#define DEFAULT_UEYE_VIDEO_FORMAT GST_VIDEO_FORMAT_BGR
-// Put matching type text in the pad template below
+#define UEYE_MIN_FREE_SEQ_BUFFERS 2   // keep this many ring buffers with the driver, copy frames rather than push the ring downstream
+#define UEYE_MIN_POOL_BUFFERS 2   // output buffers for copied frames, one being filled while downstream has the other
 
-// pad template
+#define UEYE_CAPTURE_WAIT_SLICE 100   // ms, the capture thread checks for stop at least this often
+
+#define UEYE_CLOCK_OBSERVATION_INTERVAL (250 * GST_MSECOND)  // one clock observation per interval, 32 of them span 8 s
+
+// pad template, the formats and SDK colour modes are listed in gstueyeformat.c
 static GstStaticPadTemplate gst_ueye_src_template =
 		GST_STATIC_PAD_TEMPLATE ("src",
 				GST_PAD_SRC,
 				GST_PAD_ALWAYS,
-				GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE
-						("{ BGR }"))
+				GST_STATIC_CAPS (GST_UEYE_FORMAT_TEMPLATE_CAPS)
 		);
 
 // error check, use in functions where 'src' is declared and initialised
@@ -161,40 +249,180 @@ whitebalance_get_type (void)
   return whitebalance_type;
 }
 
+#define TYPE_TRIGGER_MODE (trigger_mode_get_type ())
+static GType
+trigger_mode_get_type (void)
+{
+  static GType trigger_mode_type = 0;
+
+  if (!trigger_mode_type) {
+    static GEnumValue trigger_types[] = {
+	  { GST_TRIGGER_FREERUN, "Free running, frames at the frame rate.", "freerun" },
+	  { GST_TRIGGER_SOFTWARE, "A frame for each trigger action signal.", "software" },
+	  { GST_TRIGGER_RISING, "A frame for each rising edge on the trigger input.", "rising" },
+	  { GST_TRIGGER_FALLING, "A frame for each falling edge on the trigger input.", "falling" },
+      { 0, NULL, NULL },
+    };
+
+    trigger_mode_type =
+	g_enum_register_static ("TriggerModeType", trigger_types);
+  }
+
+  return trigger_mode_type;
+}
+
+#define TYPE_DEMOSAIC_METHOD (demosaic_method_get_type ())
+static GType
+demosaic_method_get_type (void)
+{
+  static GType demosaic_method_type = 0;
+
+  if (!demosaic_method_type) {
+    static GEnumValue demosaic_types[] = {
+	  { GST_UEYE_DEMOSAIC_SDK, "The SDK converts the Bayer data, single threaded.", "sdk" },
+	  { GST_UEYE_DEMOSAIC_BILINEAR, "Bilinear, in the element, SIMD and multi-threaded.", "bilinear" },
+	  { GST_UEYE_DEMOSAIC_MHC, "Malvar-He-Cutler, in the element, sharper with less colour fringing.", "mhc" },
+      { 0, NULL, NULL },
+    };
+
+    demosaic_method_type =
+	g_enum_register_static ("GstUEyeDemosaicMethod", demosaic_types);
+  }
+
+  return demosaic_method_type;
+}
+
+#define TYPE_OVERFLOW_POLICY (overflow_policy_get_type ())
+static GType
+overflow_policy_get_type (void)
+{
+  static GType overflow_policy_type = 0;
+
+  if (!overflow_policy_type) {
+    static GEnumValue policy_types[] = {
+	  { GST_UEYE_OVERFLOW_DROP_OLDEST, "Drop the oldest queued frame.", "drop-oldest" },
+	  { GST_UEYE_OVERFLOW_DROP_NEWEST, "Drop the new frame.", "drop-newest" },
+	  { GST_UEYE_OVERFLOW_BLOCK, "Wait for space, the camera drops frames once its ring is full.", "block" },
+      { 0, NULL, NULL },
+    };
+
+    overflow_policy_type =
+	g_enum_register_static ("UEyeOverflowPolicy", policy_types);
+  }
+
+  return overflow_policy_type;
+}
+
+// Program the exposure and a frame rate to suit it, exposure and framerate return the values actually set,
+// readout the time to read the sensor out, the shortest frame time with this pixel clock and window
+static void
+gst_ueye_program_exposure (GstUEyeSrc * src, gdouble * exposure, gdouble maxframerate, gdouble * framerate, GstClockTime * readout)
+{
+	double dblMin, dblMax, dblInterval;
+
+	if (src->fixed_framerate > 0.0) {
+		// the rate downstream asked for, the exposure has to fit in the frame with room for the sync pulse
+		*framerate = src->fixed_framerate;
+		*exposure = MAX(MIN(*exposure, 1000.0/src->fixed_framerate - UEYE_REQUIRED_SYNC_PULSE_WIDTH), 0.01);
+	}
+	else {
+		*framerate = 1000.0/(*exposure + UEYE_REQUIRED_SYNC_PULSE_WIDTH); // set a suitable frame rate for the exposure, if too fast for usb camera it will slow down, but add ms to exposure so there is always an output pulse in the deadtime created between frames.
+		*framerate = MIN(*framerate, maxframerate);
+	}
+	GST_DEBUG_OBJECT(src, "Request frame rate to %.1f and exposure to %.1f ms", *framerate, *exposure);
+	is_SetFrameRate(src->hCam, *framerate, framerate); // set a suitable frame rate for the exposure, if too fast for usb camera will slow it down, get the actual frame rate back
+	is_Exposure(src->hCam, IS_EXPOSURE_CMD_SET_EXPOSURE, (void*)exposure, sizeof(*exposure));
+	// Get the exposure value actually set back from the camera
+	is_Exposure(src->hCam, IS_EXPOSURE_CMD_GET_EXPOSURE, (void*)exposure, sizeof(*exposure));
+
+	if (is_GetFrameTimeRange(src->hCam, &dblMin, &dblMax, &dblInterval) == IS_SUCCESS)
+		*readout = (GstClockTime) (dblMin * GST_SECOND);  // s
+	else
+		*readout = (GstClockTime) (GST_SECOND / *framerate);
+}
+
 static void
 gst_ueye_set_camera_exposure (GstUEyeSrc * src, gboolean send)
 {  // How should the pipeline be told/respond to a change in frame rate - seems to be ok with a push source
-	src->framerate = 1000.0/(src->exposure + UEYE_REQUIRED_SYNC_PULSE_WIDTH); // set a suitable frame rate for the exposure, if too fast for usb camera it will slow down, but add ms to exposure so there is always an output pulse in the deadtime created between frames.
-	src->framerate = MIN(src->framerate, src->maxframerate);
-	src->duration = 1000000000.0/src->framerate;  // frame duration in ns
+	gdouble exposure, maxframerate, fixed_framerate, framerate;
+	GstClockTime readout, duration;
+
+	// Properties and the parameter batch change these, work on a copy as apply_parameters does
+	g_mutex_lock (&src->params_lock);
+	exposure = src->exposure;
+	maxframerate = src->maxframerate;
+	fixed_framerate = src->fixed_framerate;
+	readout = src->readout;
+	g_mutex_unlock (&src->params_lock);
+
+	if (fixed_framerate > 0.0)
+		framerate = fixed_framerate;
+	else {
+		framerate = 1000.0/(exposure + UEYE_REQUIRED_SYNC_PULSE_WIDTH); // set a suitable frame rate for the exposure, if too fast for usb camera it will slow down, but add ms to exposure so there is always an output pulse in the deadtime created between frames.
+		framerate = MIN(framerate, maxframerate);
+	}
 	if (send){
-		GST_DEBUG_OBJECT(src, "Request frame rate to %.1f, duration %d us, and exposure to %.1f ms", src->framerate, GST_TIME_AS_USECONDS(src->duration), src->exposure);
-		is_SetFrameRate(src->hCam, src->framerate, &src->framerate); // set a suitable frame rate for the exposure, if too fast for usb camera will slow it down, get the actual frame rate back
-		is_Exposure(src->hCam, IS_EXPOSURE_CMD_SET_EXPOSURE, (void*)&(src->exposure), sizeof(src->exposure));
-		// Get the exposure value actually set back from the camera
-		is_Exposure(src->hCam, IS_EXPOSURE_CMD_GET_EXPOSURE, (void*)&(src->exposure), sizeof(src->exposure));
-		// Update the duration to the actual value
-		src->duration = 1000000000.0/src->framerate;  // frame duration in ns
-		GST_DEBUG_OBJECT(src, "Set frame rate to %.1f, duration %d us, and exposure to %.1f ms", src->framerate, GST_TIME_AS_USECONDS(src->duration), src->exposure);
+		g_mutex_lock (&src->apply_lock);
+		gst_ueye_program_exposure(src, &exposure, maxframerate, &framerate, &readout);
+		g_mutex_unlock (&src->apply_lock);
 	}
+
+	g_mutex_lock (&src->params_lock);
+	// keep what the camera actually set, unless there is already a newer request
+	if (send && !(src->params_pending & UEYE_PARAM_EXPOSURE))
+		src->exposure = exposure;
+	duration = 1000000000.0/framerate;  // frame duration in ns
+	src->framerate = framerate;
+	src->duration = duration;
+	src->readout = readout;
+	g_mutex_unlock (&src->params_lock);
+
+	if (send)
+		GST_DEBUG_OBJECT(src, "Set frame rate to %.1f, duration %d us, and exposure to %.1f ms", framerate, GST_TIME_AS_USECONDS(duration), exposure);
 }
 
+// Program binning and subsampling, each 1, 2 or 4 in both directions, the flags for both directions go in one call.
+// A mode the sensor does not have is left off. The image size changes, so the capture must be stopped.
 static void
 gst_ueye_set_camera_binning (GstUEyeSrc * src)
 {
-	if(src->binning==2){
-		is_SetBinning(src->hCam, IS_BINNING_2X_VERTICAL);
-		is_SetBinning(src->hCam, IS_BINNING_2X_HORIZONTAL);
-	}
-	else{
+	gint factor;
+	INT mode, supported;
+
+	g_mutex_lock (&src->params_lock);
+	factor = src->binning;
+	g_mutex_unlock (&src->params_lock);
+	mode = factor == 4 ? (IS_BINNING_4X_VERTICAL | IS_BINNING_4X_HORIZONTAL)
+			: factor == 2 ? (IS_BINNING_2X_VERTICAL | IS_BINNING_2X_HORIZONTAL) : IS_BINNING_DISABLE;
+	supported = is_SetBinning(src->hCam, IS_GET_SUPPORTED_BINNING);
+	if ((mode & supported) != mode || is_SetBinning(src->hCam, mode) != IS_SUCCESS) {
+		GST_WARNING_OBJECT (src, "The sensor cannot bin %dx%d, binning is off", factor, factor);
 		is_SetBinning(src->hCam, IS_BINNING_DISABLE);
+		factor = 1;
 	}
+	src->binning_factor = factor;
+
+	g_mutex_lock (&src->params_lock);
+	factor = src->subsampling;
+	g_mutex_unlock (&src->params_lock);
+	mode = factor == 4 ? (IS_SUBSAMPLING_4X_VERTICAL | IS_SUBSAMPLING_4X_HORIZONTAL)
+			: factor == 2 ? (IS_SUBSAMPLING_2X_VERTICAL | IS_SUBSAMPLING_2X_HORIZONTAL) : IS_SUBSAMPLING_DISABLE;
+	supported = is_SetSubSampling(src->hCam, IS_GET_SUPPORTED_SUBSAMPLING);
+	if ((mode & supported) != mode || is_SetSubSampling(src->hCam, mode) != IS_SUCCESS) {
+		GST_WARNING_OBJECT (src, "The sensor cannot subsample %dx%d (with %dx%d binning), subsampling is off",
+				factor, factor, src->binning_factor, src->binning_factor);
+		is_SetSubSampling(src->hCam, IS_SUBSAMPLING_DISABLE);
+		factor = 1;
+	}
+	src->binning_factor *= factor;
+
+	GST_DEBUG_OBJECT (src, "Each pixel is %d x %d sensor pixels", src->binning_factor, src->binning_factor);
 }
 
 static void
-gst_ueye_set_camera_whitebalance (GstUEyeSrc * src)
+gst_ueye_set_camera_whitebalance (GstUEyeSrc * src, WhiteBalanceType whitebalance)
 {
-	switch (src->whitebalance){
+	switch (whitebalance){
 		double dblAutoWb;
 	case GST_WB_AUTO:   // the following code is from the uEye demo program (tabProcessing.cpp)
 		dblAutoWb = 0.0;
@@ -217,6 +445,202 @@ gst_ueye_set_camera_whitebalance (GstUEyeSrc * src)
 	}
 }
 
+// Make the gamma or LUT file curve and put it in the camera's LUT if there is one.
+// Otherwise it is applied by us as frames are copied, or by the SDK, depending on the format (see set_caps).
+static gboolean
+gst_ueye_src_setup_lut (GstUEyeSrc * src)
+{
+	IS_LUT_SUPPORT_INFO support;
+	IS_LUT_CONFIGURATION_64 config;
+	UINT nEnabled = IS_LUT_DISABLED;
+	INT nMode = IS_LUT_MODE_ID_FORCE_HARDWARE;
+	INT nGamma = 100;  // SDK software gamma is gamma x 100, 1.0 is off
+	GError *err = NULL;
+
+	src->lut_mode = GST_UEYE_LUT_NONE;
+	if (src->lut_file != NULL && src->lut_file[0] != '\0') {
+		if (!gst_ueye_lut_load_file(src->lut, src->lut_file, &err)) {
+			GST_ELEMENT_ERROR (src, RESOURCE, READ, ("Could not read the LUT file."), ("%s", err->message));
+			g_error_free (err);
+			return FALSE;
+		}
+		src->lut_mode = GST_UEYE_LUT_SOFTWARE;
+	}
+	else if (src->gamma != 1.0) {
+		gst_ueye_lut_make_gamma(src->lut, src->gamma);
+		src->lut_mode = GST_UEYE_LUT_SOFTWARE;
+	}
+
+	// The camera's LUT costs nothing on the host, it has 64 points and interpolates between them
+	memset (&support, 0, sizeof(support));
+	if (src->lut_mode != GST_UEYE_LUT_NONE
+			&& is_LUT(src->hCam, IS_LUT_CMD_GET_SUPPORT_INFO, (void*)&support, sizeof(support)) == IS_SUCCESS
+			&& support.bSupportLUTHardware) {
+		gst_ueye_lut_to_config(src->lut, &config);
+		if (is_LUT(src->hCam, IS_LUT_CMD_SET_MODE, (void*)&nMode, sizeof(nMode)) == IS_SUCCESS
+				&& is_LUT(src->hCam, IS_LUT_CMD_SET_USER_LUT, (void*)&config, sizeof(config)) == IS_SUCCESS) {
+			nEnabled = IS_LUT_ENABLED;
+			src->lut_mode = GST_UEYE_LUT_HARDWARE;
+		}
+	}
+	is_LUT(src->hCam, IS_LUT_CMD_SET_ENABLED, (void*)&nEnabled, sizeof(nEnabled));
+	is_Gamma(src->hCam, IS_GAMMA_CMD_SET, (void*)&nGamma, sizeof(nGamma));
+
+	GST_DEBUG_OBJECT (src, "Gamma %.2f, LUT file %s, LUT mode %d", src->gamma, src->lut_file ? src->lut_file : "none", src->lut_mode);
+
+	return TRUE;
+}
+
+// Our table maps 8 bit intensity samples: grey, Bayer, BGR and BGRx, not chroma or deeper samples
+static void
+gst_ueye_src_set_lut_format (GstUEyeSrc * src, const GstUEyeFormat * format)
+{
+	INT nGamma = 100;
+
+	if (src->lut_mode != GST_UEYE_LUT_SOFTWARE && src->lut_mode != GST_UEYE_LUT_SDK)
+		return;
+
+	if (format->format != GST_VIDEO_FORMAT_UYVY
+			&& (format->nBitsPerPixel == 8 || format->nBitsPerPixel == 24 || format->nBitsPerPixel == 32)) {
+		src->lut_mode = GST_UEYE_LUT_SOFTWARE;
+	}
+	else {
+		// the SDK can apply gamma to these on the host, a LUT file cannot be used
+		if (src->lut_file != NULL && src->lut_file[0] != '\0')
+			GST_WARNING_OBJECT (src, "The LUT file cannot be applied to this format, using gamma %.2f", src->gamma);
+		nGamma = src->gamma * 100;
+		src->lut_mode = GST_UEYE_LUT_SDK;
+	}
+	is_Gamma(src->hCam, IS_GAMMA_CMD_SET, (void*)&nGamma, sizeof(nGamma));
+}
+
+// Read the AOI limits for the current binning and subsampling, the sensor can only read out windows on these steps
+static void
+gst_ueye_src_get_aoi_limits (GstUEyeSrc * src)
+{
+	src->aoi_max.s32Width = src->SensorInfo.nMaxWidth / src->binning_factor;
+	src->aoi_max.s32Height = src->SensorInfo.nMaxHeight / src->binning_factor;
+	is_AOI(src->hCam, IS_AOI_IMAGE_GET_SIZE_MAX, (void*)&(src->aoi_max), sizeof(src->aoi_max));
+
+	src->aoi_min = src->aoi_max;
+	is_AOI(src->hCam, IS_AOI_IMAGE_GET_SIZE_MIN, (void*)&(src->aoi_min), sizeof(src->aoi_min));
+
+	src->aoi_inc.s32Width = 1;
+	src->aoi_inc.s32Height = 1;
+	is_AOI(src->hCam, IS_AOI_IMAGE_GET_SIZE_INC, (void*)&(src->aoi_inc), sizeof(src->aoi_inc));
+	src->aoi_inc.s32Width = MAX(src->aoi_inc.s32Width, 1);
+	src->aoi_inc.s32Height = MAX(src->aoi_inc.s32Height, 1);
+
+	src->aoi_pos_inc.s32X = 1;
+	src->aoi_pos_inc.s32Y = 1;
+	is_AOI(src->hCam, IS_AOI_IMAGE_GET_POS_INC, (void*)&(src->aoi_pos_inc), sizeof(src->aoi_pos_inc));
+	src->aoi_pos_inc.s32X = MAX(src->aoi_pos_inc.s32X, 1);
+	src->aoi_pos_inc.s32Y = MAX(src->aoi_pos_inc.s32Y, 1);
+
+	GST_DEBUG_OBJECT (src, "AOI size %d x %d to %d x %d in steps of %d x %d, position steps %d x %d",
+			src->aoi_min.s32Width, src->aoi_min.s32Height, src->aoi_max.s32Width, src->aoi_max.s32Height,
+			src->aoi_inc.s32Width, src->aoi_inc.s32Height, src->aoi_pos_inc.s32X, src->aoi_pos_inc.s32Y);
+}
+
+// The AOI position, on the sensor's position steps and leaving room for at least the smallest window
+static void
+gst_ueye_src_get_aoi_position (GstUEyeSrc * src, IS_POINT_2D * pos)
+{
+	pos->s32X = MIN(src->aoi_x, src->aoi_max.s32Width - src->aoi_min.s32Width);
+	pos->s32Y = MIN(src->aoi_y, src->aoi_max.s32Height - src->aoi_min.s32Height);
+	pos->s32X -= pos->s32X % src->aoi_pos_inc.s32X;
+	pos->s32Y -= pos->s32Y % src->aoi_pos_inc.s32Y;
+}
+
+// Width or height for caps: the property value if set, otherwise any size the sensor can read out from the AOI position
+static void
+gst_ueye_src_get_aoi_range (GValue * value, gint set, gint pos, gint min, gint max, gint inc)
+{
+	max = max - pos;
+	max -= (max - min) % inc;
+
+	if (set > 0) {
+		set = CLAMP(set, min, max);
+		set -= (set - min) % inc;
+		g_value_init (value, G_TYPE_INT);
+		g_value_set_int (value, set);
+	}
+	else if (min == max) {
+		g_value_init (value, G_TYPE_INT);
+		g_value_set_int (value, max);
+	}
+	else {
+		g_value_init (value, GST_TYPE_INT_RANGE);
+		gst_value_set_int_range_step (value, min, max, inc);
+	}
+}
+
+// Program the negotiated window, fewer lines read out is what allows the higher frame rates
+static gboolean
+gst_ueye_src_set_aoi (GstUEyeSrc * src, gint width, gint height)
+{
+	IS_POINT_2D pos;
+	IS_RECT rect;
+
+	gst_ueye_src_get_aoi_position (src, &pos);
+	rect.s32X = pos.s32X;
+	rect.s32Y = pos.s32Y;
+	rect.s32Width = width;
+	rect.s32Height = height;
+
+	GST_DEBUG_OBJECT (src, "is_AOI %d x %d at %d, %d", width, height, rect.s32X, rect.s32Y);
+	if (is_AOI(src->hCam, IS_AOI_IMAGE_SET_AOI, (void*)&rect, sizeof(rect)) != IS_SUCCESS) {
+		GST_ERROR_OBJECT (src, "The sensor cannot read out a %d x %d window at %d, %d", width, height, rect.s32X, rect.s32Y);
+		return FALSE;
+	}
+
+	is_AOI(src->hCam, IS_AOI_IMAGE_GET_AOI, (void*)&rect, sizeof(rect));
+	if (rect.s32Width != width || rect.s32Height != height) {
+		GST_ERROR_OBJECT (src, "The sensor set a %d x %d window, not %d x %d", rect.s32Width, rect.s32Height, width, height);
+		return FALSE;
+	}
+
+	src->nWidth = width;
+	src->nHeight = height;
+
+	// The frame time range depends on the window, so program the frame rate and exposure again
+	gst_ueye_set_camera_exposure(src, UEYE_UPDATE_CAMERA);
+
+	return TRUE;
+}
+
+// Allocate a ring of image memories and hand them to the SDK as a sequence with an image queue.
+// The driver fills them in turn, is_WaitForNextImage gives us the oldest filled one already locked.
+static gboolean
+gst_ueye_src_alloc_sequence (GstUEyeSrc * src)
+{
+	src->allocator = gst_ueye_allocator_new(src->hCam, src->nWidth, src->nHeight, src->nBitsPerPixel, src->num_buffers_sdk);
+	if (src->allocator == NULL)
+		return FALSE;
+
+	// All buffers are the same, get the real pitch from the first one
+	is_InquireImageMem(src->hCam, src->allocator->pcSeqImgMem[0], src->allocator->lSeqMemId[0], &(src->nWidth), &(src->nHeight), &(src->nBitsPerPixel), &(src->nPitch));
+
+	// The image queue locks each buffer as it is filled, until we unlock it after reading
+	GST_DEBUG_OBJECT (src, "is_InitImageQueue");
+	UEYEEXECANDCHECK(is_InitImageQueue(src->hCam, 0));
+
+	return TRUE;
+}
+
+static void
+gst_ueye_src_free_sequence (GstUEyeSrc * src)
+{
+	if (src->allocator == NULL)
+		return;
+
+	is_ExitImageQueue(src->hCam);
+	// Buffers still downstream keep the allocator, and so their memory, alive
+	gst_ueye_allocator_release_sequence(src->allocator);
+	gst_object_unref(src->allocator);
+	src->allocator = NULL;
+}
+
 /* class initialisation */
 
 G_DEFINE_TYPE (GstUEyeSrc, gst_ueye_src, GST_TYPE_PUSH_SRC);
@@ -244,10 +668,18 @@ gst_ueye_src_class_init (GstUEyeSrcClass * klass)
 			"uEye Video Source", "Source/Video",
 			"uEye Camera video source", "Paul R. Barber <paul.barber@oncology.ox.ac.uk>");
 
+	gstelement_class->change_state = GST_DEBUG_FUNCPTR (gst_ueye_src_change_state);
+
 	gstbasesrc_class->start = GST_DEBUG_FUNCPTR (gst_ueye_src_start);
 	gstbasesrc_class->stop = GST_DEBUG_FUNCPTR (gst_ueye_src_stop);
+	gstbasesrc_class->unlock = GST_DEBUG_FUNCPTR (gst_ueye_src_unlock);
+	gstbasesrc_class->unlock_stop = GST_DEBUG_FUNCPTR (gst_ueye_src_unlock_stop);
 	gstbasesrc_class->get_caps = GST_DEBUG_FUNCPTR (gst_ueye_src_get_caps);
 	gstbasesrc_class->set_caps = GST_DEBUG_FUNCPTR (gst_ueye_src_set_caps);
+	gstbasesrc_class->decide_allocation = GST_DEBUG_FUNCPTR (gst_ueye_src_decide_allocation);
+	gstbasesrc_class->query = GST_DEBUG_FUNCPTR (gst_ueye_src_query);
+	gstbasesrc_class->negotiate = GST_DEBUG_FUNCPTR (gst_ueye_src_negotiate);
+	gstbasesrc_class->fixate = GST_DEBUG_FUNCPTR (gst_ueye_src_fixate);
 
 #ifdef OVERRIDE_CREATE
 	gstpushsrc_class->create = GST_DEBUG_FUNCPTR (gst_ueye_src_create);
@@ -291,10 +723,16 @@ gst_ueye_src_class_init (GstUEyeSrcClass * klass)
 	g_object_class_install_property (gobject_class, PROP_BGAIN,
 	  g_param_spec_int("bgain", "Blue Gain", "Camera sensor blue channel gain.", 0, 100, DEFAULT_PROP_BGAIN,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING)));
-	// binning property, cannot be changed on the fly as image size changes
+	// binning property, changing it while playing renegotiates caps for the new image size
 	g_object_class_install_property (gobject_class, PROP_BINNING,
-	  g_param_spec_int("binning", "Binning", "Camera sensor binning. Not sure this works - FIXME!", 1, 2, DEFAULT_PROP_BINNING,
-          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+	  g_param_spec_int("binning", "Binning", "Camera sensor binning, 1, 2 or 4 (3 is taken as 2) in both directions. "
+			  "Changing it while playing renegotiates the image size.", 1, 4, DEFAULT_PROP_BINNING,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING)));
+	// subsampling property, as binning but skipping pixels rather than adding them
+	g_object_class_install_property (gobject_class, PROP_SUBSAMPLING,
+	  g_param_spec_int("subsampling", "Subsampling", "Camera sensor subsampling, 1, 2 or 4 (3 is taken as 2) in both directions, "
+			  "reads out every 2nd or 4th pixel. Changing it while playing renegotiates the image size.", 1, 4, DEFAULT_PROP_SUBSAMPLING,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING)));
 	// vflip property
 	g_object_class_install_property (gobject_class, PROP_VERT_FLIP,
 	  g_param_spec_int("vflip", "Vertical flip", "Image up-down flip.", 0, 1, DEFAULT_PROP_HORIZ_FLIP,
@@ -312,6 +750,153 @@ gst_ueye_src_class_init (GstUEyeSrcClass * klass)
 	  g_param_spec_double("maxframerate", "Maximum Frame Rate", "Camera sensor maximum allowed frame rate (fps)."
 			  "The frame rate will be determined from the exposure time, up to this maximum value when short exposures are used", 10, 200, DEFAULT_PROP_MAXFRAMERATE,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING)));
+	// Number of SDK image memories property
+	g_object_class_install_property (gobject_class, PROP_NUM_BUFFERS_SDK,
+	  g_param_spec_int("num-buffers-sdk", "SDK Buffers", "Number of image memories in the ring the camera captures into. "
+			  "More buffers absorb later reading of frames without tearing, at the cost of memory.", 2, 64, DEFAULT_PROP_NUM_BUFFERS_SDK,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+	// Dropped frames statistic
+	g_object_class_install_property (gobject_class, PROP_DROPPED_FRAMES,
+	  g_param_spec_uint64("dropped-frames", "Dropped Frames", "Frames lost since the start of streaming, from gaps in the camera's frame counter.",
+			  0, G_MAXUINT64, 0, (GParamFlags) (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+	// Transfer failures statistic
+	g_object_class_install_property (gobject_class, PROP_TRANSFER_FAILURES,
+	  g_param_spec_uint("transfer-failures", "Transfer Failures", "Image transfers the SDK reported as failed since the start of streaming.",
+			  0, G_MAXUINT, 0, (GParamFlags) (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+	// Timeouts statistic
+	g_object_class_install_property (gobject_class, PROP_TIMEOUTS,
+	  g_param_spec_int("timeouts", "Timeouts", "Waits for a frame that timed out since the start of streaming.",
+			  0, G_MAXINT, 0, (GParamFlags) (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property (gobject_class, PROP_TIMEOUT_RETRIES,
+	  g_param_spec_int("timeout-retries", "Timeout Retries", "Waits for a frame that may time out one after another before it is "
+			  "an error, each is counted in timeouts. 0 fails on the first, -1 waits for ever.",
+			  -1, G_MAXINT, DEFAULT_PROP_TIMEOUT_RETRIES,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING)));
+	// Reconnection after the camera is unplugged or reset
+	g_object_class_install_property (gobject_class, PROP_RECONNECT_TIMEOUT,
+	  g_param_spec_int("reconnect-timeout", "Reconnect Timeout", "ms to wait for a removed camera to come back, it is then opened "
+			  "again with the same settings and streaming carries on. 0 to fail as soon as it is removed.",
+			  0, G_MAXINT, DEFAULT_PROP_RECONNECT_TIMEOUT,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING)));
+	g_object_class_install_property (gobject_class, PROP_RECONNECTS,
+	  g_param_spec_uint("reconnects", "Reconnects", "Times the camera was removed and opened again since the start of streaming.",
+			  0, G_MAXUINT, 0, (GParamFlags) (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+	// Frame statistics for exposure control
+	g_object_class_install_property (gobject_class, PROP_STATISTICS,
+	  g_param_spec_boolean("statistics", "Statistics", "Take a histogram, the mean, min, max and saturated fraction of each channel "
+			  "of every frame, as a GstUEyeStatsMeta on the buffer and in ueyesrc-statistics element messages.",
+			  DEFAULT_PROP_STATISTICS,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING)));
+	g_object_class_install_property (gobject_class, PROP_STATISTICS_STEP,
+	  g_param_spec_int("statistics-step", "Statistics Step", "Statistics are taken from every step'th pixel of every step'th row "
+			  "(made even for raw Bayer).",
+			  1, 256, DEFAULT_PROP_STATISTICS_STEP,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING)));
+	g_object_class_install_property (gobject_class, PROP_STATISTICS_INTERVAL,
+	  g_param_spec_int("statistics-interval", "Statistics Interval", "Least ms between ueyesrc-statistics messages, 0 for every frame. "
+			  "The buffer meta is on every frame.",
+			  0, G_MAXINT, DEFAULT_PROP_STATISTICS_INTERVAL,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING)));
+	// AOI properties, the window size can also be chosen by caps negotiation
+	g_object_class_install_property (gobject_class, PROP_AOI_X,
+	  g_param_spec_int("aoi-x", "AOI X", "Left edge of the sensor area of interest (pixels), rounded down to the sensor's position step.",
+			  0, G_MAXINT, DEFAULT_PROP_AOI_X,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+	g_object_class_install_property (gobject_class, PROP_AOI_Y,
+	  g_param_spec_int("aoi-y", "AOI Y", "Top edge of the sensor area of interest (pixels), rounded down to the sensor's position step.",
+			  0, G_MAXINT, DEFAULT_PROP_AOI_Y,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+	g_object_class_install_property (gobject_class, PROP_AOI_WIDTH,
+	  g_param_spec_int("aoi-width", "AOI Width", "Width of the sensor area of interest (pixels), 0 to let caps negotiation choose.",
+			  0, G_MAXINT, DEFAULT_PROP_AOI_WIDTH,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+	g_object_class_install_property (gobject_class, PROP_AOI_HEIGHT,
+	  g_param_spec_int("aoi-height", "AOI Height", "Height of the sensor area of interest (pixels), 0 to let caps negotiation choose.",
+			  0, G_MAXINT, DEFAULT_PROP_AOI_HEIGHT,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+	// Camera selection properties
+	g_object_class_install_property (gobject_class, PROP_DEVICE_ID,
+	  g_param_spec_int("device-id", "Device ID", "SDK device id of the camera to open, 0 for the first usable camera.",
+			  0, 255, DEFAULT_PROP_DEVICE_ID,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+	g_object_class_install_property (gobject_class, PROP_SERIAL,
+	  g_param_spec_string("serial", "Serial Number", "Serial number of the camera to open, used in preference to device-id.",
+			  DEFAULT_PROP_SERIAL,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+	// Capture queue properties
+	g_object_class_install_property (gobject_class, PROP_QUEUE_SIZE,
+	  g_param_spec_int("queue-size", "Queue Size", "Frames the capture thread can queue ahead of the pipeline. "
+			  "Limited to num-buffers-sdk less the buffers the camera needs to capture into.", 1, 63, DEFAULT_PROP_QUEUE_SIZE,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+	g_object_class_install_property (gobject_class, PROP_OVERFLOW_POLICY,
+	  g_param_spec_enum("overflow-policy", "Overflow Policy", "What to do with a new frame when the pipeline has not taken the queued ones.",
+			  TYPE_OVERFLOW_POLICY, DEFAULT_PROP_OVERFLOW_POLICY,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING)));
+	// Queue depth statistic
+	g_object_class_install_property (gobject_class, PROP_QUEUE_DEPTH,
+	  g_param_spec_uint("queue-depth", "Queue Depth", "Frames captured and waiting for the pipeline.",
+			  0, G_MAXUINT, 0, (GParamFlags) (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+	// Trigger properties
+	g_object_class_install_property (gobject_class, PROP_TRIGGER_MODE,
+	  g_param_spec_enum("trigger-mode", "Trigger Mode", "Free running, or a frame for each software trigger or edge on the trigger input.",
+			  TYPE_TRIGGER_MODE, DEFAULT_PROP_TRIGGER_MODE,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+	g_object_class_install_property (gobject_class, PROP_TRIGGER_TIMEOUT,
+	  g_param_spec_int("trigger-timeout", "Trigger Timeout", "Time to wait for a triggered frame (ms), 0 to wait for ever.",
+			  0, G_MAXINT, DEFAULT_PROP_TRIGGER_TIMEOUT,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING)));
+
+	// Action signal to take a frame in software trigger mode, or force one when waiting for a hardware trigger
+	gst_ueye_src_signals[SIGNAL_TRIGGER] =
+	  g_signal_new ("trigger", G_TYPE_FROM_CLASS (klass),
+			  G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION, G_STRUCT_OFFSET (GstUEyeSrcClass, trigger),
+			  NULL, NULL, NULL, G_TYPE_BOOLEAN, 0);
+	klass->trigger = gst_ueye_src_trigger;
+
+	// Action signal to read the camera parameters back from the camera, the properties return the values last set
+	gst_ueye_src_signals[SIGNAL_REFRESH] =
+	  g_signal_new ("refresh", G_TYPE_FROM_CLASS (klass),
+			  G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION, G_STRUCT_OFFSET (GstUEyeSrcClass, refresh),
+			  NULL, NULL, NULL, G_TYPE_BOOLEAN, 0);
+	klass->refresh = gst_ueye_src_refresh;
+
+	// Gamma and LUT properties
+	g_object_class_install_property (gobject_class, PROP_GAMMA,
+	  g_param_spec_double("gamma", "Gamma", "Gamma correction, 1.0 to leave the pixels untouched. "
+			  "Applied in the camera's LUT if it has one.", 0.01, 10.0, DEFAULT_PROP_GAMMA,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+	g_object_class_install_property (gobject_class, PROP_LUT_FILE,
+	  g_param_spec_string("lut-file", "LUT File", "Text file of 256 output values (0-255) used instead of gamma.",
+			  DEFAULT_PROP_LUT_FILE,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+	// Bayer demosaic properties
+	g_object_class_install_property (gobject_class, PROP_DEMOSAIC,
+	  g_param_spec_enum("demosaic", "Demosaic", "Who converts the raw sensor data to BGR, BGRx or RGB on colour cameras. "
+			  "Other formats always come from the SDK.",
+			  TYPE_DEMOSAIC_METHOD, DEFAULT_PROP_DEMOSAIC,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+	g_object_class_install_property (gobject_class, PROP_DEMOSAIC_THREADS,
+	  g_param_spec_int("demosaic-threads", "Demosaic Threads", "Threads for the element's demosaic, 0 for one per processor.",
+			  0, 64, DEFAULT_PROP_DEMOSAIC_THREADS,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+	// Fast startup
+	g_object_class_install_property (gobject_class, PROP_PARAMETER_SET,
+	  g_param_spec_string("parameter-set", "Parameter Set", "Camera configuration loaded when the camera is opened, \"eeprom\" for "
+			  "the set saved in the camera or the path of an .ini file saved by the IDS tools. Only properties that were set "
+			  "and differ from it are programmed after it.",
+			  DEFAULT_PROP_PARAMETER_SET,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property (gobject_class, PROP_STARTUP_TIME,
+	  g_param_spec_uint64("startup-time", "Startup Time", "ns from the camera starting to open to the first frame, 0 until then.",
+			  0, G_MAXUINT64, 0, (GParamFlags) (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+
+	// Parameter change sequence
+	g_object_class_install_property (gobject_class, PROP_PARAMETER_SEQUENCE,
+	  g_param_spec_uint("parameter-sequence", "Parameter Sequence", "Counts camera parameter changes. The first frame to use a change "
+			  "is followed by a ueyesrc-parameters element message with its sequence number.",
+			  0, G_MAXUINT, 0, (GParamFlags) (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
 }
 
 static void
@@ -326,29 +911,131 @@ gst_ueye_src_init (GstUEyeSrc * src)
 	// Initialise properties
 	src->exposure = DEFAULT_PROP_EXPOSURE;
 	src->pixelclock = DEFAULT_PROP_PIXELCLOCK;
-	gst_ueye_set_camera_exposure(src, UEYE_UPDATE_LOCAL);
 	src->gain = DEFAULT_PROP_GAIN;
 	src->blacklevel = DEFAULT_PROP_BLACKLEVEL;
 	src->rgain = DEFAULT_PROP_RGAIN;
 	src->ggain = DEFAULT_PROP_GGAIN;
 	src->bgain = DEFAULT_PROP_BGAIN;
 	src->binning = DEFAULT_PROP_BINNING;
+	src->subsampling = DEFAULT_PROP_SUBSAMPLING;
+	src->binning_factor = 1;
 	src->vflip = DEFAULT_PROP_VERT_FLIP;
 	src->hflip = DEFAULT_PROP_HORIZ_FLIP;
 	src->whitebalance = DEFAULT_PROP_WHITEBALANCE;
 	src->maxframerate = DEFAULT_PROP_MAXFRAMERATE;
+	src->num_buffers_sdk = DEFAULT_PROP_NUM_BUFFERS_SDK;
+	src->aoi_x = DEFAULT_PROP_AOI_X;
+	src->aoi_y = DEFAULT_PROP_AOI_Y;
+	src->aoi_width = DEFAULT_PROP_AOI_WIDTH;
+	src->aoi_height = DEFAULT_PROP_AOI_HEIGHT;
+	src->device_id = DEFAULT_PROP_DEVICE_ID;
+	src->serial = DEFAULT_PROP_SERIAL;
+	src->queue_size = DEFAULT_PROP_QUEUE_SIZE;
+	src->overflow_policy = DEFAULT_PROP_OVERFLOW_POLICY;
+	src->trigger_mode = DEFAULT_PROP_TRIGGER_MODE;
+	src->trigger_timeout = DEFAULT_PROP_TRIGGER_TIMEOUT;
+	src->gamma = DEFAULT_PROP_GAMMA;
+	src->lut_file = DEFAULT_PROP_LUT_FILE;
+	src->lut_mode = GST_UEYE_LUT_NONE;
+	src->demosaic_method = DEFAULT_PROP_DEMOSAIC;
+	src->demosaic_threads = DEFAULT_PROP_DEMOSAIC_THREADS;
+	src->demosaic = NULL;
+	src->demosaicing = FALSE;
+	src->sample_shift = 0;
+	src->depth_pending = FALSE;
+	src->capture_thread = NULL;
+	src->queue = NULL;
+	src->params_pending = 0;
+	src->params_seq = 0;
+	src->params_applied_seq = 0;
+	src->params_applied_time = 0;
+	src->params_tagged_seq = 0;
+	src->params_set = 0;
+	src->binning_set = FALSE;
+	g_mutex_init (&src->params_lock);
+	g_mutex_init (&src->apply_lock);
+	// the frame rate for the default exposure, it takes the locks
+	gst_ueye_set_camera_exposure(src, UEYE_UPDATE_LOCAL);
+
+	src->allocator = NULL;
+	src->format = NULL;
+	src->use_video_meta = FALSE;
+
+	src->parameter_set = DEFAULT_PROP_PARAMETER_SET;
+	src->open_thread = NULL;
+	src->opening = FALSE;
+	src->open_serial = NULL;
+	src->open_device_id = 0;
+	src->startup_begin = 0;
+	src->open_time = 0;
+	src->startup_time = 0;
+	src->reconnect_timeout = DEFAULT_PROP_RECONNECT_TIMEOUT;
+	src->timeout_retries = DEFAULT_PROP_TIMEOUT_RETRIES;
+	src->statistics = DEFAULT_PROP_STATISTICS;
+	src->statistics_step = DEFAULT_PROP_STATISTICS_STEP;
+	src->statistics_interval = DEFAULT_PROP_STATISTICS_INTERVAL;
+	src->stats_valid = FALSE;
+	src->unlocking = FALSE;
+	src->camera_serial = NULL;
 
 	gst_ueye_src_reset (src);
 }
 
+// Set the camera handle, or clear it and with it camera_open
+static void
+gst_ueye_src_set_handle (GstUEyeSrc * src, HIDS hCam)
+{
+	GST_OBJECT_LOCK (src);
+	src->hCam = hCam;
+	if (hCam == 0)
+		src->camera_open = FALSE;
+	GST_OBJECT_UNLOCK (src);
+}
+
+// TRUE once the camera is initialised and its sensor info and AOI limits read, for threads that did not open it
+static gboolean
+gst_ueye_src_is_open (GstUEyeSrc * src)
+{
+	gboolean open;
+
+	GST_OBJECT_LOCK (src);
+	open = src->camera_open;
+	GST_OBJECT_UNLOCK (src);
+
+	return open;
+}
+
 static void
 gst_ueye_src_reset (GstUEyeSrc * src)
 {
-	src->hCam=0;
+	gst_ueye_src_set_handle (src, 0);
 	src->cameraPresent = FALSE;
 	src->n_frames=0;
 	src->total_timeouts = 0;
 	src->last_frame_time = 0;
+	src->have_first_frame = FALSE;
+	src->first_frame_number = 0;
+	src->last_frame_number = 0;
+	src->total_dropped = 0;
+	src->total_transfer_failures = 0;
+	src->last_capture_status = 0;
+
+	src->clock_n_obs = 0;
+	src->clock_obs_idx = 0;
+	src->clock_cand_valid = FALSE;
+	src->clock_calibrated = FALSE;
+
+	src->readout = 0;
+	src->latency = GST_CLOCK_TIME_NONE;
+	src->fixed_framerate = 0.0;
+
+	src->device_lost = FALSE;
+	src->discont = FALSE;
+	src->stats_valid = FALSE;
+	src->stats_posted = 0;
+	src->reconnects = 0;
+	src->offset_base = 0;
+	src->last_offset = 0;
 }
 
 void
@@ -356,64 +1043,161 @@ gst_ueye_src_set_property (GObject * object, guint property_id,
 		const GValue * value, GParamSpec * pspec)
 {
 	GstUEyeSrc *src;
+	guint changed = 0;
+	gboolean resize = FALSE;
 
 	src = GST_UEYE_SRC (object);
 
+	// Camera parameters are recorded here and programmed into the camera as a batch,
+	// by the capture thread between frames, so we do not race it or wait for the camera
+	g_mutex_lock (&src->params_lock);
+
 	switch (property_id) {
 	case PROP_CAMERAPRESENT:
 		src->cameraPresent = g_value_get_boolean (value);
 		break;
 	case PROP_PIXELCLOCK:
 		src->pixelclock = g_value_get_int (value);
-		is_PixelClock(src->hCam, IS_PIXELCLOCK_CMD_SET, (void*)&(src->pixelclock), sizeof(src->pixelclock));
+		changed = UEYE_PARAM_PIXELCLOCK;
 		break;
 	case PROP_EXPOSURE:
 		src->exposure = g_value_get_double(value);
-		gst_ueye_set_camera_exposure(src, UEYE_UPDATE_CAMERA);
+		changed = UEYE_PARAM_EXPOSURE;
 		break;
 	case PROP_GAIN:
 		src->gain = g_value_get_int (value);
-		is_SetHardwareGain(src->hCam, src->gain, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
+		changed = UEYE_PARAM_GAIN;
 		break;
 	case PROP_BLACKLEVEL:
 		src->blacklevel = g_value_get_int (value);
-		is_Blacklevel(src->hCam, IS_BLACKLEVEL_CMD_SET_OFFSET, (void*)&(src->blacklevel), sizeof(src->blacklevel));
+		changed = UEYE_PARAM_BLACKLEVEL;
 		break;
 	case PROP_RGAIN:
 		src->rgain = g_value_get_int (value);
-		is_SetHardwareGain(src->hCam, IS_IGNORE_PARAMETER, src->rgain, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
+		changed = UEYE_PARAM_RGAIN;
 		break;
 	case PROP_GGAIN:
 		src->ggain = g_value_get_int (value);
-		is_SetHardwareGain(src->hCam, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, src->ggain, IS_IGNORE_PARAMETER);
+		changed = UEYE_PARAM_GGAIN;
 		break;
 	case PROP_BGAIN:
 		src->bgain = g_value_get_int (value);
-		is_SetHardwareGain(src->hCam, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, src->bgain);
+		changed = UEYE_PARAM_BGAIN;
 		break;
 	case PROP_BINNING:
-		src->binning = g_value_get_int (value);
-		gst_ueye_set_camera_binning(src);
+		src->binning = g_value_get_int (value) == 3 ? 2 : g_value_get_int (value);
+		src->binning_set = TRUE;
+		resize = gst_ueye_src_is_open (src);
+		break;
+	case PROP_SUBSAMPLING:
+		src->subsampling = g_value_get_int (value) == 3 ? 2 : g_value_get_int (value);
+		src->binning_set = TRUE;
+		resize = gst_ueye_src_is_open (src);
 		break;
 	case PROP_HORIZ_FLIP:
 		src->hflip = g_value_get_int (value);
-		is_SetRopEffect(src->hCam, IS_SET_ROP_MIRROR_LEFTRIGHT, src->hflip, 0);
+		changed = UEYE_PARAM_HFLIP;
 		break;
 	case PROP_VERT_FLIP:
 		src->vflip = g_value_get_int (value);
-		is_SetRopEffect(src->hCam, IS_SET_ROP_MIRROR_UPDOWN, src->vflip, 0);
+		changed = UEYE_PARAM_VFLIP;
 		break;
 	case PROP_WHITEBALANCE:
 		src->whitebalance = g_value_get_enum (value);
-		gst_ueye_set_camera_whitebalance(src);
+		changed = UEYE_PARAM_WHITEBALANCE;
 		break;
 	case PROP_MAXFRAMERATE:
 		src->maxframerate = g_value_get_double(value);
+		changed = UEYE_PARAM_EXPOSURE;
+		break;
+	case PROP_NUM_BUFFERS_SDK:
+		src->num_buffers_sdk = g_value_get_int (value);
+		break;
+	case PROP_AOI_X:
+		src->aoi_x = g_value_get_int (value);
+		break;
+	case PROP_AOI_Y:
+		src->aoi_y = g_value_get_int (value);
+		break;
+	case PROP_AOI_WIDTH:
+		src->aoi_width = g_value_get_int (value);
+		break;
+	case PROP_AOI_HEIGHT:
+		src->aoi_height = g_value_get_int (value);
+		break;
+	case PROP_DEVICE_ID:
+		src->device_id = g_value_get_int (value);
+		break;
+	case PROP_SERIAL:
+		g_free (src->serial);
+		src->serial = g_value_dup_string (value);
+		break;
+	case PROP_QUEUE_SIZE:
+		src->queue_size = g_value_get_int (value);
+		break;
+	case PROP_OVERFLOW_POLICY:
+		src->overflow_policy = g_value_get_enum (value);
+		break;
+	case PROP_TRIGGER_MODE:
+		src->trigger_mode = g_value_get_enum (value);
+		break;
+	case PROP_TRIGGER_TIMEOUT:
+		src->trigger_timeout = g_value_get_int (value);
+		break;
+	case PROP_GAMMA:
+		src->gamma = g_value_get_double (value);
+		break;
+	case PROP_LUT_FILE:
+		g_free (src->lut_file);
+		src->lut_file = g_value_dup_string (value);
+		break;
+	case PROP_DEMOSAIC:
+		src->demosaic_method = g_value_get_enum (value);
+		break;
+	case PROP_DEMOSAIC_THREADS:
+		src->demosaic_threads = g_value_get_int (value);
+		break;
+	case PROP_PARAMETER_SET:
+		g_free (src->parameter_set);
+		src->parameter_set = g_value_dup_string (value);
+		break;
+	case PROP_RECONNECT_TIMEOUT:
+		src->reconnect_timeout = g_value_get_int (value);
+		break;
+	case PROP_TIMEOUT_RETRIES:
+		src->timeout_retries = g_value_get_int (value);
+		break;
+	case PROP_STATISTICS:
+		src->statistics = g_value_get_boolean (value);
+		break;
+	case PROP_STATISTICS_STEP:
+		src->statistics_step = g_value_get_int (value);
+		break;
+	case PROP_STATISTICS_INTERVAL:
+		src->statistics_interval = g_value_get_int (value);
 		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
 		break;
 	}
+
+	if (changed) {
+		src->params_pending |= changed;
+		src->params_set |= changed;
+		src->params_seq++;
+	}
+	if (resize)
+		src->resize_pending = TRUE;
+
+	g_mutex_unlock (&src->params_lock);
+
+	// The image size changes, the streaming thread renegotiates before its next frame, see gst_ueye_src_negotiate
+	if (resize)
+		gst_pad_mark_reconfigure (GST_BASE_SRC_PAD (src));
+
+	// Without the capture thread, program the camera now (opening the camera programs everything anyway)
+	if (changed && gst_ueye_src_is_open (src) && !g_atomic_int_get (&src->capture_running) && !g_atomic_int_get (&src->opening))
+		gst_ueye_src_apply_parameters (src);
 }
 
 void
@@ -425,41 +1209,41 @@ gst_ueye_src_get_property (GObject * object, guint property_id,
 	g_return_if_fail (GST_IS_UEYE_SRC (object));
 	src = GST_UEYE_SRC (object);
 
+	// Camera parameters come from the cache of what was last set, or read back by the refresh signal,
+	// polling them does not talk to the camera
+	g_mutex_lock (&src->params_lock);
+
 	switch (property_id) {
 	case PROP_CAMERAPRESENT:
 		g_value_set_boolean (value, src->cameraPresent);
 		break;
 	case PROP_PIXELCLOCK:
-		is_PixelClock(src->hCam, IS_PIXELCLOCK_CMD_GET, (void*)&(src->pixelclock), sizeof(src->pixelclock));
 		g_value_set_int (value, src->pixelclock);
 		break;
 	case PROP_EXPOSURE:
-		is_Exposure(src->hCam, IS_EXPOSURE_CMD_GET_EXPOSURE, (void*)&(src->exposure), sizeof(src->exposure));
 		g_value_set_double (value, src->exposure);
 		break;
 	case PROP_GAIN:
-		src->gain = is_SetHardwareGain(src->hCam, IS_GET_MASTER_GAIN, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
 		g_value_set_int (value, src->gain);
 		break;
 	case PROP_BLACKLEVEL:
-		is_Blacklevel(src->hCam, IS_BLACKLEVEL_CMD_GET_OFFSET, (void*)&(src->blacklevel), sizeof(src->blacklevel));
 		g_value_set_int (value, src->blacklevel);
 		break;
 	case PROP_RGAIN:
-		src->rgain = is_SetHardwareGain(src->hCam, IS_GET_RED_GAIN, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
 		g_value_set_int (value, src->rgain);
 		break;
 	case PROP_GGAIN:
-		src->ggain = is_SetHardwareGain(src->hCam, IS_GET_GREEN_GAIN, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
 		g_value_set_int (value, src->ggain);
 		break;
 	case PROP_BGAIN:
-		src->bgain = is_SetHardwareGain(src->hCam, IS_GET_BLUE_GAIN, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
 		g_value_set_int (value, src->bgain);
 		break;
 	case PROP_BINNING:
 		g_value_set_int (value, src->binning);
 		break;
+	case PROP_SUBSAMPLING:
+		g_value_set_int (value, src->subsampling);
+		break;
 	case PROP_HORIZ_FLIP:
 		g_value_set_int (value, src->hflip);
 		break;
@@ -472,10 +1256,108 @@ gst_ueye_src_get_property (GObject * object, guint property_id,
 	case PROP_MAXFRAMERATE:
 		g_value_set_double (value, src->maxframerate);
 		break;
+	case PROP_NUM_BUFFERS_SDK:
+		g_value_set_int (value, src->num_buffers_sdk);
+		break;
+	case PROP_AOI_X:
+		g_value_set_int (value, src->aoi_x);
+		break;
+	case PROP_AOI_Y:
+		g_value_set_int (value, src->aoi_y);
+		break;
+	case PROP_AOI_WIDTH:
+		g_value_set_int (value, src->aoi_width);
+		break;
+	case PROP_AOI_HEIGHT:
+		g_value_set_int (value, src->aoi_height);
+		break;
+	case PROP_DEVICE_ID:
+		g_value_set_int (value, src->device_id);
+		break;
+	case PROP_SERIAL:
+		g_value_set_string (value, src->serial);
+		break;
+	case PROP_QUEUE_SIZE:
+		g_value_set_int (value, src->queue_size);
+		break;
+	case PROP_OVERFLOW_POLICY:
+		g_value_set_enum (value, src->overflow_policy);
+		break;
+	case PROP_TRIGGER_MODE:
+		g_value_set_enum (value, src->trigger_mode);
+		break;
+	case PROP_TRIGGER_TIMEOUT:
+		g_value_set_int (value, src->trigger_timeout);
+		break;
+	case PROP_GAMMA:
+		g_value_set_double (value, src->gamma);
+		break;
+	case PROP_LUT_FILE:
+		g_value_set_string (value, src->lut_file);
+		break;
+	case PROP_DEMOSAIC:
+		g_value_set_enum (value, src->demosaic_method);
+		break;
+	case PROP_DEMOSAIC_THREADS:
+		g_value_set_int (value, src->demosaic_threads);
+		break;
+	case PROP_PARAMETER_SEQUENCE:
+		g_value_set_uint (value, src->params_seq);
+		break;
+	case PROP_PARAMETER_SET:
+		g_value_set_string (value, src->parameter_set);
+		break;
+	case PROP_STARTUP_TIME:
+		GST_OBJECT_LOCK (src);
+		g_value_set_uint64 (value, src->startup_time);
+		GST_OBJECT_UNLOCK (src);
+		break;
+	case PROP_RECONNECT_TIMEOUT:
+		g_value_set_int (value, src->reconnect_timeout);
+		break;
+	case PROP_TIMEOUT_RETRIES:
+		g_value_set_int (value, src->timeout_retries);
+		break;
+	case PROP_STATISTICS:
+		g_value_set_boolean (value, src->statistics);
+		break;
+	case PROP_STATISTICS_STEP:
+		g_value_set_int (value, src->statistics_step);
+		break;
+	case PROP_STATISTICS_INTERVAL:
+		g_value_set_int (value, src->statistics_interval);
+		break;
+	case PROP_RECONNECTS:
+		GST_OBJECT_LOCK (src);
+		g_value_set_uint (value, src->reconnects);
+		GST_OBJECT_UNLOCK (src);
+		break;
+	case PROP_QUEUE_DEPTH:
+		GST_OBJECT_LOCK (src);
+		g_value_set_uint (value, src->queue ? gst_ueye_queue_get_depth (src->queue) : 0);
+		GST_OBJECT_UNLOCK (src);
+		break;
+	case PROP_DROPPED_FRAMES:
+		GST_OBJECT_LOCK (src);
+		g_value_set_uint64 (value, src->total_dropped);
+		GST_OBJECT_UNLOCK (src);
+		break;
+	case PROP_TRANSFER_FAILURES:
+		GST_OBJECT_LOCK (src);
+		g_value_set_uint (value, src->total_transfer_failures);
+		GST_OBJECT_UNLOCK (src);
+		break;
+	case PROP_TIMEOUTS:
+		GST_OBJECT_LOCK (src);
+		g_value_set_int (value, src->total_timeouts);
+		GST_OBJECT_UNLOCK (src);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
 		break;
 	}
+
+	g_mutex_unlock (&src->params_lock);
 }
 
 void
@@ -504,131 +1386,437 @@ gst_ueye_src_finalize (GObject * object)
 	GST_DEBUG_OBJECT (src, "finalize");
 
 	/* clean up object here */
+	if (gst_ueye_src_join_open (src))
+		is_ExitCamera(src->hCam);
+	g_free (src->serial);
+	src->serial = NULL;
+	g_free (src->lut_file);
+	src->lut_file = NULL;
+	g_free (src->parameter_set);
+	src->parameter_set = NULL;
+	g_free (src->open_serial);
+	src->open_serial = NULL;
+	g_free (src->camera_serial);
+	src->camera_serial = NULL;
+	g_mutex_clear (&src->params_lock);
+	g_mutex_clear (&src->apply_lock);
 	G_OBJECT_CLASS (gst_ueye_src_parent_class)->finalize (object);
 }
 
+// Resolve the serial or device-id property from the SDK camera list into the handle to pass to is_InitCamera,
+// 0 for the first usable camera
 static gboolean
-gst_ueye_src_start (GstBaseSrc * bsrc)
+gst_ueye_src_select_camera (GstUEyeSrc * src, HIDS * phCam)
 {
-	// Start will open the device but not start it, set_caps starts it, stop should stop and close it (as v4l2src)
-
-	GstUEyeSrc *src = GST_UEYE_SRC (bsrc);
-
-	GST_DEBUG_OBJECT (src, "start");
+	UEYE_CAMERA_LIST *list;
+	const UEYE_CAMERA_INFO *info;
+
+	if ((src->serial == NULL || src->serial[0] == '\0') && src->device_id == 0)
+		return TRUE;
+
+	list = gst_ueye_camera_list_new();
+	info = gst_ueye_camera_list_find(list, src->serial, src->device_id);
+	if (info == NULL) {
+		if (src->serial != NULL && src->serial[0] != '\0')
+			GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND, ("No uEye camera with serial number %s.", src->serial), (NULL));
+		else
+			GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND, ("No uEye camera with device id %d.", src->device_id), (NULL));
+		g_free(list);
+		return FALSE;
+	}
+	if (info->dwInUse) {
+		GST_ELEMENT_ERROR (src, RESOURCE, BUSY, ("uEye camera %d is in use.", info->dwDeviceID), (NULL));
+		g_free(list);
+		return FALSE;
+	}
 
-	// Turn on automatic timestamping, if so we do not need to do it manually, BUT there is some evidence that automatic timestamping is laggy
-//	gst_base_src_set_do_timestamp(bsrc, TRUE);
+	GST_DEBUG_OBJECT (src, "Using camera %d, serial %.16s, model %.16s", info->dwDeviceID, info->SerNo, info->Model);
+	*phCam = (HIDS) (info->dwDeviceID | IS_USE_DEVICE_ID);
+	g_free(list);
 
-	// read libversion (for informational purposes only)
-	int version = is_GetDLLVersion();
-	int build = version & 0xFFFF;
-	version = version >> 16;
-	int minor = version & 0xFF;
-	version = version >> 8;
-	int major = version & 0xFF;
-	GST_INFO_OBJECT (src, "uEye Library Ver %d.%d.%d", major, minor, build);
+	return TRUE;
+}
 
+// Load a complete camera configuration in one operation, from the camera's EEPROM or from an .ini file
+// saved by the IDS tools, instead of programming the parameters one by one
+static gboolean
+gst_ueye_src_load_parameter_set (GstUEyeSrc * src)
+{
+	INT nRet;
 
-	// open first usable device
-	GST_DEBUG_OBJECT (src, "is_InitCamera");
-	src->hCam=0;
-	UEYEEXECANDCHECK(is_InitCamera(&(src->hCam), NULL));
+	GST_DEBUG_OBJECT (src, "is_ParameterSet load %s", src->parameter_set);
+	if (g_ascii_strcasecmp (src->parameter_set, "eeprom") == 0)
+		nRet = is_ParameterSet(src->hCam, IS_PARAMETERSET_CMD_LOAD_EEPROM, NULL, 0);
+	else {
+		// the SDK takes a wide character path, wchar_t is UCS-4 on Linux
+		gunichar *path = g_utf8_to_ucs4 (src->parameter_set, -1, NULL, NULL, NULL);
 
-	// display error when no camera has been found
-	if(!src->hCam)
-	{
-		GST_ERROR_OBJECT (src, "No uEye device found.");
-		goto fail;
+		nRet = path != NULL ? is_ParameterSet(src->hCam, IS_PARAMETERSET_CMD_LOAD_FILE, (void*)path, 0) : IS_INVALID_PARAMETER;
+		g_free (path);
 	}
 
-	// NOTE:
-	// from now on, the "hCam" handle can be used to access the camera board.
-	// use is_ExitCamera to end the usage
-	src->cameraPresent = TRUE;
+	if (nRet != IS_SUCCESS) {
+		GST_ELEMENT_ERROR (src, RESOURCE, SETTINGS, ("Could not load the uEye parameter set %s.", src->parameter_set),
+				("is_ParameterSet returned %d", nRet));
+		return FALSE;
+	}
 
-	// Enable the receiving of frame events (we wait for these in create)
-	GST_DEBUG_OBJECT (src, "is_EnableEvent");
-	UEYEEXECANDCHECK(is_EnableEvent(src->hCam, IS_SET_EVENT_FRAME_RECEIVED));
-	// TODO what is IS_SET_EVENT_FIRST_PACKET_RECEIVED?
+	return TRUE;
+}
 
-	// Get information about the camera sensor
+// After a parameter set the camera has its own values. Program only the properties that were set and differ
+// from them, as one batch, and take the camera's values for the rest.
+static void
+gst_ueye_src_apply_differences (GstUEyeSrc * src)
+{
+	gint pixelclock = 0, gain, blacklevel = 0, rgain, ggain, bgain;
+	gdouble exposure = 0.0, framerate = 0.0;
+	double dblMin, dblMax, dblInterval;
+	guint set, differ = 0;
+	INT binning, subsampling;
+
+	is_PixelClock(src->hCam, IS_PIXELCLOCK_CMD_GET, (void*)&pixelclock, sizeof(pixelclock));
+	is_Exposure(src->hCam, IS_EXPOSURE_CMD_GET_EXPOSURE, (void*)&exposure, sizeof(exposure));
+	gain = is_SetHardwareGain(src->hCam, IS_GET_MASTER_GAIN, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
+	is_Blacklevel(src->hCam, IS_BLACKLEVEL_CMD_GET_OFFSET, (void*)&blacklevel, sizeof(blacklevel));
+	rgain = is_SetHardwareGain(src->hCam, IS_GET_RED_GAIN, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
+	ggain = is_SetHardwareGain(src->hCam, IS_GET_GREEN_GAIN, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
+	bgain = is_SetHardwareGain(src->hCam, IS_GET_BLUE_GAIN, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
+
+	g_mutex_lock (&src->params_lock);
+	set = src->params_set;
+	if ((set & UEYE_PARAM_PIXELCLOCK) && src->pixelclock != pixelclock)
+		differ |= UEYE_PARAM_PIXELCLOCK;
+	else
+		src->pixelclock = pixelclock;
+	// the frame rate follows the exposure (or maxframerate, which sets the same flag)
+	if ((set & UEYE_PARAM_EXPOSURE) && fabs (src->exposure - exposure) > 0.001)
+		differ |= UEYE_PARAM_EXPOSURE;
+	else if (!(set & UEYE_PARAM_EXPOSURE))
+		src->exposure = exposure;
+	if ((set & UEYE_PARAM_GAIN) && src->gain != gain)
+		differ |= UEYE_PARAM_GAIN;
+	else
+		src->gain = gain;
+	if ((set & UEYE_PARAM_BLACKLEVEL) && src->blacklevel != blacklevel)
+		differ |= UEYE_PARAM_BLACKLEVEL;
+	else
+		src->blacklevel = blacklevel;
+	if ((set & UEYE_PARAM_RGAIN) && src->rgain != rgain)
+		differ |= UEYE_PARAM_RGAIN;
+	else
+		src->rgain = rgain;
+	if ((set & UEYE_PARAM_GGAIN) && src->ggain != ggain)
+		differ |= UEYE_PARAM_GGAIN;
+	else
+		src->ggain = ggain;
+	if ((set & UEYE_PARAM_BGAIN) && src->bgain != bgain)
+		differ |= UEYE_PARAM_BGAIN;
+	else
+		src->bgain = bgain;
+	// these cannot be read back, program them if they were set
+	differ |= set & (UEYE_PARAM_HFLIP | UEYE_PARAM_VFLIP | UEYE_PARAM_WHITEBALANCE);
+	src->params_pending = differ;
+	g_mutex_unlock (&src->params_lock);
+
+	GST_DEBUG_OBJECT (src, "Parameters set 0x%x, differing from the parameter set 0x%x", set, differ);
+
+	// the frame rate and its limits as the parameter set left them, unless the exposure is programmed again
+	if (!(differ & (UEYE_PARAM_PIXELCLOCK | UEYE_PARAM_EXPOSURE))) {
+		is_SetFrameRate(src->hCam, IS_GET_FRAMERATE, &framerate);
+		if (framerate > 0.0) {
+			src->framerate = framerate;
+			src->duration = 1000000000.0/framerate;  // frame duration in ns
+		}
+		if (is_GetFrameTimeRange(src->hCam, &dblMin, &dblMax, &dblInterval) == IS_SUCCESS)
+			src->readout = (GstClockTime) (dblMin * GST_SECOND);
+	}
+	gst_ueye_src_apply_parameters (src);
+
+	if (src->binning_set)
+		gst_ueye_set_camera_binning(src);
+	else {
+		binning = is_SetBinning(src->hCam, IS_GET_BINNING);
+		subsampling = is_SetSubSampling(src->hCam, IS_GET_SUBSAMPLING);
+		g_mutex_lock (&src->params_lock);
+		src->binning = (binning & IS_BINNING_4X_HORIZONTAL) ? 4 : (binning & IS_BINNING_2X_HORIZONTAL) ? 2 : 1;
+		src->subsampling = (subsampling & IS_SUBSAMPLING_4X_HORIZONTAL) ? 4 : (subsampling & IS_SUBSAMPLING_2X_HORIZONTAL) ? 2 : 1;
+		src->binning_factor = src->binning * src->subsampling;
+		g_mutex_unlock (&src->params_lock);
+	}
+}
+
+// Initialise the camera selected by hCam and program it, when it is opened or opened again after being removed.
+// This is the long chain of USB round trips that makes bring-up slow, a parameter set shortens it.
+// Other threads see it as open (camera_open) only once the sensor info and AOI limits have been read.
+static gboolean
+gst_ueye_src_init_camera (GstUEyeSrc * src, HIDS hCam)
+{
+	gint64 begin = g_get_monotonic_time ();
+	CAMINFO camInfo;
+	guint seq;
+	INT nRet;
+
+	g_mutex_lock (&src->params_lock);
+	seq = src->params_seq;
+	g_mutex_unlock (&src->params_lock);
+
+	GST_DEBUG_OBJECT (src, "is_InitCamera");
+	nRet = is_InitCamera(&hCam, NULL);
+	if (nRet != IS_SUCCESS) {
+		GST_ERROR_OBJECT (src, "is_InitCamera failed with %d", nRet);
+		hCam = 0;
+	}
+
+	// display error when no camera has been found
+	if(!hCam)
+	{
+		GST_ERROR_OBJECT (src, "No uEye device found.");
+		goto fail;
+	}
+
+	// Get information about the camera sensor
 	GST_DEBUG_OBJECT (src, "is_GetSensorInfo");
-	UEYEEXECANDCHECK(is_GetSensorInfo(src->hCam, &(src->SensorInfo)));
+	UEYEEXECANDCHECK(is_GetSensorInfo(hCam, &(src->SensorInfo)));
+	src->sensor_depths = gst_ueye_format_get_depths(hCam);
+
+	// NOTE:
+	// from now on, the "hCam" handle can be used to access the camera board, by this thread until camera_open is set.
+	// use is_ExitCamera to end the usage
+	gst_ueye_src_set_handle (src, hCam);
+	src->cameraPresent = TRUE;
+
+	// The serial number to open again if the camera is removed, whichever way it was chosen
+	if (is_GetCameraInfo(src->hCam, &camInfo) == IS_SUCCESS) {
+		g_free (src->camera_serial);
+		src->camera_serial = g_strndup (camInfo.SerNo, sizeof(camInfo.SerNo));
+	}
 
-	// We will use the the full sensor
+	// Tell us if it is unplugged or drops off the bus, see gst_ueye_src_camera_removed
+	if (is_EnableEvent(src->hCam, IS_SET_EVENT_REMOVE) != IS_SUCCESS)
+		GST_WARNING_OBJECT (src, "Cannot enable the removal event, a removed camera will not be opened again");
+
+	// Until caps are set we will use the the full sensor
 	src->nWidth = src->SensorInfo.nMaxWidth;
 	src->nHeight = src->SensorInfo.nMaxHeight;
 
-	// Colour format
-	//is_SetColorMode() can tell us the color mode
-	//src->pSensorInfo->nColorMode reports on a different color 'mode'
-	// We support just colour of one type, BGR 24-bit, I am not attempting to support all camera types
-	src->nBitsPerPixel = 24;
-
-	// Alloc some buffers
-	GST_DEBUG_OBJECT (src, "is_AllocImageMem");
-	UEYEEXECANDCHECK(is_AllocImageMem(src->hCam, src->nWidth, src->nHeight, src->nBitsPerPixel, &(src->pcImgMem), &(src->lMemId)));
-
-	// from uEyePixelPeekDlg.cpp demo code
-	GST_DEBUG_OBJECT (src, "is_SetImageMem");
-	UEYEEXECANDCHECK(is_SetImageMem(src->hCam, src->pcImgMem, src->lMemId));
-	GST_DEBUG_OBJECT (src, "is_InquireImageMem");
-	is_InquireImageMem(src->hCam, src->pcImgMem, src->lMemId, &(src->nWidth), &(src->nHeight), &(src->nBitsPerPixel), &(src->nPitch));
-	src->nBytesPerPixel = (src->nBitsPerPixel+1)/8;
-	src->nImageSize = src->nWidth * src->nHeight * src->nBytesPerPixel;
-	GST_DEBUG_OBJECT (src, "Image is %d x %d, pitch %d, bpp %d, Bpp %d", src->nWidth, src->nHeight, src->nPitch, src->nBitsPerPixel, src->nBytesPerPixel);
+	// The colour mode, and so the image memory, is chosen in set_caps from the negotiated format
+	GST_DEBUG_OBJECT (src, "Sensor %s is %d x %d, colour mode %d", src->SensorInfo.strSensorName, src->nWidth, src->nHeight, src->SensorInfo.nColorMode);
 
-	is_PixelClock(src->hCam, IS_PIXELCLOCK_CMD_SET, (void*)&(src->pixelclock), sizeof(src->pixelclock));
-
-	//is_SetHardwareGamma(src->hCam, IS_SET_HW_GAMMA_ON);  // Hardware gamma is rubbish at the low intensity range
-	// set software gamma to some value, times value by 100 and send to camera, i.e. for 1.8 send 180
-	{
-		INT nGamma=180;
-		is_Gamma(src->hCam, IS_GAMMA_CMD_SET, (void*)&nGamma, sizeof(nGamma));
+	if (src->parameter_set != NULL && src->parameter_set[0] != '\0') {
+		// everything, the flash output included, comes from the set, then the properties that differ
+		if (!gst_ueye_src_load_parameter_set(src))
+			goto fail;
+		if (!gst_ueye_src_setup_lut(src))
+			goto fail;
+		gst_ueye_src_apply_differences(src);
 	}
+	else {
+		is_PixelClock(src->hCam, IS_PIXELCLOCK_CMD_SET, (void*)&(src->pixelclock), sizeof(src->pixelclock));
 
-	// turn on the output 'flash' sync pulse direct from the camera
-	{
-		UINT nMode;
-		IO_FLASH_PARAMS flashParams;
-		UINT nValue;
+		//is_SetHardwareGamma(src->hCam, IS_SET_HW_GAMMA_ON);  // Hardware gamma is rubbish at the low intensity range
+		// gamma or a LUT, in the camera's LUT if it has one, otherwise applied as frames are copied
+		if (!gst_ueye_src_setup_lut(src))
+			goto fail;
+
+		// turn on the output 'flash' sync pulse direct from the camera
+		{
+			UINT nMode;
+			IO_FLASH_PARAMS flashParams;
+			UINT nValue;
+
+			GST_DEBUG_OBJECT (src, "Setting flash trigger. is_IO()");
 
-		GST_DEBUG_OBJECT (src, "Setting flash trigger. is_IO()");
+			// when triggered, the pulse follows each triggered exposure
+			nMode = src->trigger_mode == GST_TRIGGER_FREERUN ? IO_FLASH_MODE_FREERUN_HI_ACTIVE : IO_FLASH_MODE_TRIGGER_HI_ACTIVE;
+			UEYEEXECANDCHECK(is_IO(src->hCam, IS_IO_CMD_FLASH_SET_MODE, (void*)&nMode, sizeof(nMode)));
 
-		nMode = IO_FLASH_MODE_FREERUN_HI_ACTIVE;
-		UEYEEXECANDCHECK(is_IO(src->hCam, IS_IO_CMD_FLASH_SET_MODE, (void*)&nMode, sizeof(nMode)));
+			flashParams.s32Delay = 0;
+			flashParams.u32Duration = 0; // 5000; // us, or 0=exposure time
+			UEYEEXECANDCHECK(is_IO(src->hCam, IS_IO_CMD_FLASH_SET_PARAMS, (void*)&flashParams, sizeof(flashParams)));
 
-		flashParams.s32Delay = 0;
-		flashParams.u32Duration = 0; // 5000; // us, or 0=exposure time
-		UEYEEXECANDCHECK(is_IO(src->hCam, IS_IO_CMD_FLASH_SET_PARAMS, (void*)&flashParams, sizeof(flashParams)));
+			// Enable flash auto freerun
+			nValue = src->trigger_mode == GST_TRIGGER_FREERUN ? IS_FLASH_AUTO_FREERUN_ON : IS_FLASH_AUTO_FREERUN_OFF;
+			UEYEEXECANDCHECK(is_IO(src->hCam, IS_IO_CMD_FLASH_SET_AUTO_FREERUN, (void*)&nValue, sizeof(nValue)));
+		}
+
+		gst_ueye_set_camera_exposure(src, UEYE_UPDATE_CAMERA);
+		is_SetHardwareGain(src->hCam, src->gain, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
+		is_Blacklevel(src->hCam, IS_BLACKLEVEL_CMD_SET_OFFSET, (void*)&(src->blacklevel), sizeof(src->blacklevel));
+		is_SetHardwareGain(src->hCam, IS_IGNORE_PARAMETER, src->rgain, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
+		is_SetHardwareGain(src->hCam, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, src->ggain, IS_IGNORE_PARAMETER);
+		is_SetHardwareGain(src->hCam, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, src->bgain);
+		gst_ueye_set_camera_binning(src);
+		is_SetRopEffect(src->hCam, IS_SET_ROP_MIRROR_LEFTRIGHT, src->hflip, 0);
+		is_SetRopEffect(src->hCam, IS_SET_ROP_MIRROR_UPDOWN, src->vflip, 0);
+		gst_ueye_set_camera_whitebalance(src, src->whitebalance);
+	}
 
-		// Enable flash auto freerun
-		nValue = IS_FLASH_AUTO_FREERUN_ON;
-		UEYEEXECANDCHECK(is_IO(src->hCam, IS_IO_CMD_FLASH_SET_AUTO_FREERUN, (void*)&nValue, sizeof(nValue)));
+	// Everything is programmed, nothing is pending, unless properties were set while we were opening
+	g_mutex_lock (&src->params_lock);
+	if (src->params_seq == seq) {
+		src->params_pending = 0;
+		src->params_applied_seq = src->params_seq;
+		src->params_tagged_seq = src->params_seq;
 	}
+	g_mutex_unlock (&src->params_lock);
+	g_atomic_int_set (&src->opening, FALSE);
+	gst_ueye_src_apply_parameters(src);
 
-	gst_ueye_set_camera_exposure(src, UEYE_UPDATE_CAMERA);
-	is_SetHardwareGain(src->hCam, src->gain, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
-	is_Blacklevel(src->hCam, IS_BLACKLEVEL_CMD_SET_OFFSET, (void*)&(src->blacklevel), sizeof(src->blacklevel));
-	is_SetHardwareGain(src->hCam, IS_IGNORE_PARAMETER, src->rgain, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
-	is_SetHardwareGain(src->hCam, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, src->ggain, IS_IGNORE_PARAMETER);
-	is_SetHardwareGain(src->hCam, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, src->bgain);
-	gst_ueye_set_camera_binning(src);
-	is_SetRopEffect(src->hCam, IS_SET_ROP_MIRROR_LEFTRIGHT, src->hflip, 0);
-	is_SetRopEffect(src->hCam, IS_SET_ROP_MIRROR_UPDOWN, src->vflip, 0);
-	gst_ueye_set_camera_whitebalance(src);
+	// The AOI limits depend on the binning
+	gst_ueye_src_get_aoi_limits(src);
+
+	// Now caps and latency can be worked out from it
+	GST_OBJECT_LOCK (src);
+	src->camera_open = TRUE;
+	GST_OBJECT_UNLOCK (src);
+
+	// Cache what the camera actually took, it may have rounded or limited the values
+	gst_ueye_src_refresh(src);
+
+	src->open_time = (g_get_monotonic_time () - begin) * GST_USECOND;
+	GST_INFO_OBJECT (src, "Camera opened and programmed in %" GST_TIME_FORMAT, GST_TIME_ARGS (src->open_time));
 
 	return TRUE;
 
 	fail:
-	if (src->hCam) {
-		is_ExitCamera(src->hCam);
-		src->hCam = 0;
-	}
+	g_atomic_int_set (&src->opening, FALSE);
+	gst_ueye_src_set_handle (src, 0);
+	if (hCam)
+		is_ExitCamera(hCam);
 
 	return FALSE;
 }
 
+// Open the camera given by the serial or device-id property, in the open thread from NULL to READY, or in start
+static gboolean
+gst_ueye_src_open_camera (GstUEyeSrc * src)
+{
+	HIDS hCam = 0;
+
+	// read libversion (for informational purposes only)
+	int version = is_GetDLLVersion();
+	int build = version & 0xFFFF;
+	version = version >> 16;
+	int minor = version & 0xFF;
+	version = version >> 8;
+	int major = version & 0xFF;
+	GST_INFO_OBJECT (src, "uEye Library Ver %d.%d.%d", major, minor, build);
+
+	g_mutex_lock (&src->params_lock);
+	g_free (src->open_serial);
+	src->open_serial = g_strdup (src->serial);
+	src->open_device_id = src->device_id;
+	g_mutex_unlock (&src->params_lock);
+
+	// open the camera given by serial number or device id, otherwise the first usable device
+	if (!gst_ueye_src_select_camera(src, &hCam)) {
+		g_atomic_int_set (&src->opening, FALSE);
+		return FALSE;
+	}
+
+	return gst_ueye_src_init_camera(src, hCam);
+}
+
+static gpointer
+gst_ueye_src_open_thread (gpointer data)
+{
+	GstUEyeSrc *src = GST_UEYE_SRC (data);
+
+	return GINT_TO_POINTER (gst_ueye_src_open_camera (src));
+}
+
+// Wait for the camera being opened in the background, TRUE if it is open
+static gboolean
+gst_ueye_src_join_open (GstUEyeSrc * src)
+{
+	gboolean opened;
+
+	if (src->open_thread == NULL)
+		return gst_ueye_src_is_open (src);
+
+	opened = GPOINTER_TO_INT (g_thread_join (src->open_thread));
+	src->open_thread = NULL;
+
+	return opened;
+}
+
+static GstStateChangeReturn
+gst_ueye_src_change_state (GstElement * element, GstStateChange transition)
+{
+	GstUEyeSrc *src = GST_UEYE_SRC (element);
+	GstStateChangeReturn ret;
+
+	switch (transition) {
+	case GST_STATE_CHANGE_NULL_TO_READY:
+		// Open the camera in the background, so that the cameras of a pipeline come up together
+		// rather than one after another as the bin changes their state. start waits for it.
+		src->startup_begin = g_get_monotonic_time ();
+		g_atomic_int_set (&src->opening, TRUE);
+		src->open_thread = g_thread_new ("ueyesrc-open", gst_ueye_src_open_thread, src);
+		break;
+	default:
+		break;
+	}
+
+	ret = GST_ELEMENT_CLASS (gst_ueye_src_parent_class)->change_state (element, transition);
+
+	switch (transition) {
+	case GST_STATE_CHANGE_READY_TO_NULL:
+		// opened but never started
+		if (gst_ueye_src_join_open (src)) {
+			UEYEEXECANDCHECK(is_ExitCamera(src->hCam));
+			gst_ueye_src_reset (src);
+		}
+		src->startup_begin = 0;
+		break;
+	default:
+		break;
+	}
+
+	return ret;
+}
+
+static gboolean
+gst_ueye_src_start (GstBaseSrc * bsrc)
+{
+	// Start will open the device but not start it, set_caps starts it, stop should stop and close it (as v4l2src)
+
+	GstUEyeSrc *src = GST_UEYE_SRC (bsrc);
+	gboolean opening, opened, moved;
+
+	GST_DEBUG_OBJECT (src, "start");
+	g_atomic_int_set (&src->unlocking, FALSE);
+
+	// Turn on automatic timestamping, if so we do not need to do it manually, BUT there is some evidence that automatic timestamping is laggy
+//	gst_base_src_set_do_timestamp(bsrc, TRUE);
+
+	// Usually the camera was opened going to READY
+	opening = src->open_thread != NULL;
+	opened = gst_ueye_src_join_open (src);
+
+	// unless the camera was changed since
+	g_mutex_lock (&src->params_lock);
+	moved = g_strcmp0 (src->serial, src->open_serial) != 0 || src->device_id != src->open_device_id;
+	g_mutex_unlock (&src->params_lock);
+	if (opened && moved) {
+		GST_DEBUG_OBJECT (src, "The camera was changed in READY, opening it again");
+		UEYEEXECANDCHECK(is_ExitCamera(src->hCam));
+		gst_ueye_src_reset (src);
+		opened = FALSE;
+	}
+
+	// or stopped and started again without going through READY, if it failed it has posted the error
+	if (!opened && (!opening || moved)) {
+		if (src->startup_begin == 0 || moved)
+			src->startup_begin = g_get_monotonic_time ();
+		g_atomic_int_set (&src->opening, TRUE);
+		opened = gst_ueye_src_open_camera(src);
+	}
+
+	return opened;
+}
+
 static gboolean
 gst_ueye_src_stop (GstBaseSrc * bsrc)
 {
@@ -637,41 +1825,132 @@ gst_ueye_src_stop (GstBaseSrc * bsrc)
 	GstUEyeSrc *src = GST_UEYE_SRC (bsrc);
 
 	GST_DEBUG_OBJECT (src, "stop");
+	gst_ueye_src_stop_capture(src);
 	UEYEEXECANDCHECK(is_StopLiveVideo(src->hCam, IS_FORCE_VIDEO_STOP));
-	UEYEEXECANDCHECK(is_DisableEvent(src->hCam, IS_SET_EVENT_FRAME_RECEIVED));
+	gst_ueye_src_free_sequence(src);
 	UEYEEXECANDCHECK(is_ExitCamera(src->hCam));
 
+	GST_OBJECT_LOCK (src);
+	src->acq_started = FALSE;
+	GST_OBJECT_UNLOCK (src);
+	src->format = NULL;
+	src->demosaicing = FALSE;
+	src->sample_shift = 0;
+	src->depth_pending = FALSE;
+	if (src->demosaic != NULL) {
+		gst_ueye_demosaic_free (src->demosaic);
+		src->demosaic = NULL;
+	}
 	gst_ueye_src_reset (src);
 
 	return TRUE;
 }
 
-static GstCaps *
-gst_ueye_src_get_caps (GstBaseSrc * bsrc, GstCaps * filter)
+// Wake create from waiting for a frame, however long the exposure, so that a state change or a flushing seek
+// does not wait for it. The capture thread gives back the frames it cannot queue meanwhile.
+static gboolean
+gst_ueye_src_unlock (GstBaseSrc * bsrc)
 {
 	GstUEyeSrc *src = GST_UEYE_SRC (bsrc);
-	GstCaps *caps;
 
-  if (src->hCam == 0) {
-    caps = gst_pad_get_pad_template_caps (GST_BASE_SRC_PAD (src));
-  } else {
-    GstVideoInfo vinfo;
+	GST_DEBUG_OBJECT (src, "unlock");
+	g_atomic_int_set (&src->unlocking, TRUE);
+
+	GST_OBJECT_LOCK (src);
+	if (src->queue != NULL)
+		gst_ueye_queue_set_flushing (src->queue, TRUE);
+	GST_OBJECT_UNLOCK (src);
+
+	return TRUE;
+}
+
+// Frames queued before the flush are stale for a live source, give them back to the ring and queue new ones
+static gboolean
+gst_ueye_src_unlock_stop (GstBaseSrc * bsrc)
+{
+	GstUEyeSrc *src = GST_UEYE_SRC (bsrc);
+	GstUEyeFrame frame;
+	guint stale = 0;
 
-    // Create video info 
-    gst_video_info_init (&vinfo);
+	GST_DEBUG_OBJECT (src, "unlock_stop");
 
-    vinfo.width = src->nWidth;
-    vinfo.height = src->nHeight;
+	// create is not running, so we are the only consumer
+	GST_OBJECT_LOCK (src);
+	if (src->queue != NULL) {
+		while (gst_ueye_queue_try_pop (src->queue, &frame)) {
+			is_UnlockSeqBuf(src->hCam, frame.nMemId, frame.pcMem);
+			stale++;
+		}
+		gst_ueye_queue_set_flushing (src->queue, FALSE);
+	}
+	GST_OBJECT_UNLOCK (src);
+	g_atomic_int_set (&src->unlocking, FALSE);
 
-   	vinfo.fps_n = 0;  vinfo.fps_d = 1;  // Frames per second fraction n/d, 0/1 indicates a frame rate may vary
-    vinfo.interlace_mode = GST_VIDEO_INTERLACE_MODE_PROGRESSIVE;
+	if (stale > 0)
+		GST_DEBUG_OBJECT (src, "Gave back %u frames queued before the flush", stale);
 
-    vinfo.finfo = gst_video_format_get_info (DEFAULT_UEYE_VIDEO_FORMAT);
+	return TRUE;
+}
+
+// 0/1 first, so that by default the frame rate follows the exposure as it always has, then the range of fixed
+// rates the sensor can run at with the current pixel clock and window. Triggered frames have no rate.
+static void
+gst_ueye_src_get_framerate_values (GstUEyeSrc * src, GValue * value)
+{
+	GValue v = G_VALUE_INIT;
+	double dblMin, dblMax, dblInterval;
+
+	g_value_init (value, GST_TYPE_LIST);
+	g_value_init (&v, GST_TYPE_FRACTION);
+	gst_value_set_fraction (&v, 0, 1);
+	gst_value_list_append_value (value, &v);
+	g_value_unset (&v);
+
+	if (src->trigger_mode != GST_TRIGGER_FREERUN)
+		return;
+	if (is_GetFrameTimeRange(src->hCam, &dblMin, &dblMax, &dblInterval) != IS_SUCCESS || dblMin <= 0.0 || dblMax < dblMin)
+		return;
+
+	// in mHz, rounded into the range so every rate offered can be programmed
+	g_value_init (&v, GST_TYPE_FRACTION_RANGE);
+	gst_value_set_fraction_range_full (&v, (gint) ceil (1000.0/dblMax), 1000, (gint) floor (1000.0/dblMin), 1000);
+	gst_value_list_append_value (value, &v);
+	g_value_unset (&v);
+}
 
-    // cannot do this for variable frame rate
-    //src->duration = gst_util_uint64_scale_int (GST_SECOND, vinfo.fps_d, vinfo.fps_n); // NB n and d are wrong way round to invert the fps into a duration.
+static GstCaps *
+gst_ueye_src_get_caps (GstBaseSrc * bsrc, GstCaps * filter)
+{
+	GstUEyeSrc *src = GST_UEYE_SRC (bsrc);
+	GstCaps *caps;
 
-    caps = gst_video_info_to_caps (&vinfo);
+  // Until the camera is open, or while it is being opened in the background
+  if (!gst_ueye_src_is_open (src)) {
+    caps = gst_pad_get_pad_template_caps (GST_BASE_SRC_PAD (src));
+  } else {
+    GValue width = G_VALUE_INIT, height = G_VALUE_INIT, framerate = G_VALUE_INIT;
+    IS_POINT_2D pos;
+
+    // Every format the sensor can deliver, preferred first
+    caps = gst_ueye_format_get_caps (&src->SensorInfo);
+
+    // Any window on the sensor's AOI steps, unless the AOI properties fix it
+    gst_ueye_src_get_aoi_position (src, &pos);
+    gst_ueye_src_get_aoi_range (&width, src->aoi_width, pos.s32X,
+        src->aoi_min.s32Width, src->aoi_max.s32Width, src->aoi_inc.s32Width);
+    gst_ueye_src_get_aoi_range (&height, src->aoi_height, pos.s32Y,
+        src->aoi_min.s32Height, src->aoi_max.s32Height, src->aoi_inc.s32Height);
+    gst_caps_set_value (caps, "width", &width);
+    gst_caps_set_value (caps, "height", &height);
+    g_value_unset (&width);
+    g_value_unset (&height);
+
+    // Frames per second fraction n/d, 0/1 indicates a frame rate may vary
+    gst_ueye_src_get_framerate_values (src, &framerate);
+    gst_caps_set_value (caps, "framerate", &framerate);
+    g_value_unset (&framerate);
+    gst_caps_set_simple (caps,
+        "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1, NULL);
   }
 
 	GST_DEBUG_OBJECT (src, "The caps are %" GST_PTR_FORMAT, caps);
@@ -687,32 +1966,202 @@ gst_ueye_src_get_caps (GstBaseSrc * bsrc, GstCaps * filter)
 	return caps;
 }
 
+// Stop the camera and release its ring, before the image size or format changes
+static void
+gst_ueye_src_stop_acquisition (GstUEyeSrc * src)
+{
+	if (!src->acq_started)
+		return;
+
+	gst_ueye_src_stop_capture(src);
+	UEYEEXECANDCHECK(is_StopLiveVideo(src->hCam, IS_FORCE_VIDEO_STOP));
+	gst_ueye_src_free_sequence(src);
+	GST_OBJECT_LOCK (src);
+	src->acq_started = FALSE;
+	GST_OBJECT_UNLOCK (src);
+}
+
+// Binning and subsampling change the image size: stop capturing, program them and read the new window
+// limits, then negotiate caps for them. set_caps allocates a ring of the new size and starts capturing again.
+static gboolean
+gst_ueye_src_negotiate (GstBaseSrc * bsrc)
+{
+	GstUEyeSrc *src = GST_UEYE_SRC (bsrc);
+	GstCaps *caps;
+	gboolean resize, ret;
+
+	g_mutex_lock (&src->params_lock);
+	resize = src->resize_pending && gst_ueye_src_is_open (src);
+	src->resize_pending = FALSE;
+	g_mutex_unlock (&src->params_lock);
+
+	if (!resize)
+		return GST_BASE_SRC_CLASS (gst_ueye_src_parent_class)->negotiate (bsrc);
+
+	GST_INFO_OBJECT (src, "Binning %d, subsampling %d, renegotiating", src->binning, src->subsampling);
+	gst_ueye_src_stop_acquisition(src);
+	gst_ueye_set_camera_binning(src);
+	gst_ueye_src_get_aoi_limits(src);
+
+	ret = GST_BASE_SRC_CLASS (gst_ueye_src_parent_class)->negotiate (bsrc);
+
+	// Caps the same as before are not set again, start capturing at the new binning with them
+	if (ret && !src->acq_started) {
+		caps = gst_pad_get_current_caps (GST_BASE_SRC_PAD (src));
+		ret = caps != NULL && gst_ueye_src_set_caps (bsrc, caps);
+		if (caps != NULL)
+			gst_caps_unref (caps);
+	}
+
+	return ret;
+}
+
+// The largest window the caps allow, rather than the smallest, then the first of anything else
+static GstCaps *
+gst_ueye_src_fixate (GstBaseSrc * bsrc, GstCaps * caps)
+{
+	guint i;
+
+	caps = gst_caps_make_writable (caps);
+	for (i = 0; i < gst_caps_get_size (caps); i++) {
+		GstStructure *s = gst_caps_get_structure (caps, i);
+
+		gst_structure_fixate_field_nearest_int (s, "width", G_MAXINT);
+		gst_structure_fixate_field_nearest_int (s, "height", G_MAXINT);
+	}
+
+	return GST_BASE_SRC_CLASS (gst_ueye_src_parent_class)->fixate (bsrc, caps);
+}
+
 static gboolean
 gst_ueye_src_set_caps (GstBaseSrc * bsrc, GstCaps * caps)
 {
 	// Start will open the device but not start it, set_caps starts it, stop should stop and close it (as v4l2src)
 
 	GstUEyeSrc *src = GST_UEYE_SRC (bsrc);
+	GstStructure *s = gst_caps_get_structure (caps, 0);
+	const GstUEyeFormat *format;
 	GstVideoInfo vinfo;
-	//GstStructure *s = gst_caps_get_structure (caps, 0);
+	gint width, height, nColorMode, nOutBytesPerPixel;
+	gint fps_n = 0, fps_d = 1;
+	gdouble fixed_framerate, framerate, exposure;
 
 	GST_DEBUG_OBJECT (src, "The caps being set are %" GST_PTR_FORMAT, caps);
 
-	gst_video_info_from_caps (&vinfo, caps);
+	g_assert (src->hCam != 0);
+
+	format = gst_ueye_format_from_structure (&src->SensorInfo, src->sensor_depths, s);
+	if (format == NULL || !gst_structure_get_int (s, "width", &width) || !gst_structure_get_int (s, "height", &height))
+		goto unsupported_caps;
 
-	if (GST_VIDEO_INFO_FORMAT (&vinfo) != GST_VIDEO_FORMAT_UNKNOWN) {
-		g_assert (src->hCam != 0);
-		//  src->vrm_stride = get_pitch (src->device);  // wait for image to arrive for this
+	if (GST_UEYE_FORMAT_IS_BAYER (format)) {
+		// video/x-bayer rows are padded to 4 bytes, as by bayer2rgb
+		gst_video_info_init (&vinfo);
+		src->gst_stride = GST_ROUND_UP_4 (width * (format->nBitsPerPixel / 8));
+	}
+	else {
+		if (!gst_video_info_from_caps (&vinfo, caps))
+			goto unsupported_caps;
 		src->gst_stride = GST_VIDEO_INFO_COMP_STRIDE (&vinfo, 0);
-		src->nHeight = vinfo.height;
-	} else {
+	}
+	nOutBytesPerPixel = (format->nBitsPerPixel+1)/8;
+	if (src->gst_stride < width * nOutBytesPerPixel){
+		GST_ERROR_OBJECT (src, "Stride %d is too small for %d pixels of %d bytes", src->gst_stride, width, nOutBytesPerPixel);
 		goto unsupported_caps;
 	}
 
-	// start freerun/continuous capture
+	// Stop capturing into the old image memory, buffers still downstream stay valid
+	gst_ueye_src_stop_acquisition(src);
+
+	// A fixed frame rate is programmed as it is, with the exposure cut to fit, 0/1 lets it follow the exposure
+	gst_structure_get_fraction (s, "framerate", &fps_n, &fps_d);
+	g_mutex_lock (&src->params_lock);
+	src->fixed_framerate = fps_n > 0 && src->trigger_mode == GST_TRIGGER_FREERUN ? (gdouble) fps_n / fps_d : 0.0;
+	g_mutex_unlock (&src->params_lock);
+
+	// Program the window, on the sensor so that only these lines are read out and transferred
+	if (!gst_ueye_src_set_aoi(src, width, height))
+		goto unsupported_caps;
+
+	g_mutex_lock (&src->params_lock);
+	fixed_framerate = src->fixed_framerate;
+	framerate = src->framerate;
+	exposure = src->exposure;
+	g_mutex_unlock (&src->params_lock);
+	if (fixed_framerate > 0.0 && fabs (framerate - fixed_framerate) > fixed_framerate * UEYE_FRAMERATE_TOLERANCE) {
+		GST_ERROR_OBJECT (src, "The sensor cannot run at %.3f fps with a %d x %d window, the nearest is %.3f fps",
+				fixed_framerate, width, height, framerate);
+		goto unsupported_caps;
+	}
+	if (fixed_framerate > 0.0)
+		GST_DEBUG_OBJECT (src, "Fixed frame rate %d/%d, exposure %.3f ms", fps_n, fps_d, exposure);
+
+	// Debayer into BGR, BGRx or RGB ourselves if asked to, the SDK then gives us the raw sensor data
+	src->demosaicing = FALSE;
+	if (src->demosaic_method != GST_UEYE_DEMOSAIC_SDK && src->SensorInfo.nColorMode == IS_COLORMODE_BAYER
+			&& !GST_UEYE_FORMAT_IS_BAYER (format)) {
+		if (src->demosaic == NULL)
+			src->demosaic = gst_ueye_demosaic_new (src->demosaic_threads);
+		src->demosaicing = gst_ueye_demosaic_set_format (src->demosaic, src->demosaic_method,
+				gst_ueye_format_bayer_pattern (&src->SensorInfo), format->format, width, height);
+	}
 
-	UEYEEXECANDCHECK(is_CaptureVideo(src->hCam, IS_FORCE_VIDEO_START));
+	// Program the colour mode for this format, the SDK converts from the sensor data to it
+	nColorMode = src->demosaicing ? IS_CM_SENSOR_RAW8 : format->nColorMode;
+	GST_DEBUG_OBJECT (src, "is_SetColorMode %d", nColorMode);
+	UEYEEXECANDCHECK(is_SetColorMode(src->hCam, nColorMode));
+	src->format = format;
+	src->vinfo = vinfo;
+	src->nBitsPerPixel = src->demosaicing ? 8 : format->nBitsPerPixel;
+	gst_ueye_src_set_lut_format(src, format);
+	src->sample_shift = src->demosaicing ? 0 : GST_UEYE_FORMAT_SHIFT(format);
+	src->depth_pending = TRUE;
+	if (src->sample_shift > 0)
+		GST_DEBUG_OBJECT (src, "%d bit samples, shifted up by %d", format->depth, src->sample_shift);
+
+	// Alloc a ring of buffers for the camera to capture into
+	if (!gst_ueye_src_alloc_sequence(src)){
+		GST_ELEMENT_ERROR (src, RESOURCE, NO_SPACE_LEFT, ("Failed to allocate image memory."), (NULL));
+		return FALSE;
+	}
+	src->nBytesPerPixel = (src->nBitsPerPixel+1)/8;
+	src->nImageSize = src->nWidth * src->nHeight * src->nBytesPerPixel;
+	GST_DEBUG_OBJECT (src, "Image is %d x %d, pitch %d, bpp %d, Bpp %d", src->nWidth, src->nHeight, src->nPitch, src->nBitsPerPixel, src->nBytesPerPixel);
+
+	if (src->demosaicing)
+		GST_DEBUG_OBJECT (src, "Demosaicing raw %s with method %d", gst_ueye_format_bayer_pattern (&src->SensorInfo), src->demosaic_method);
+	else if (src->gst_stride != src->nPitch)
+		GST_DEBUG_OBJECT (src, "Driver pitch %d differs from stride %d, frames need video meta or repacking", src->nPitch, src->gst_stride);
+
+	// count transfer failures from zero for this stream
+	is_CaptureStatus(src->hCam, IS_CAPTURE_STATUS_INFO_CMD_RESET, NULL, 0);
+	src->last_capture_status = 0;
+
+	// start freerun/continuous capture, or arm the trigger
+	switch (src->trigger_mode) {
+	case GST_TRIGGER_SOFTWARE:
+		// each trigger signal captures one frame with is_FreezeVideo
+		UEYEEXECANDCHECK(is_SetExternalTrigger(src->hCam, IS_SET_TRIGGER_SOFTWARE));
+		break;
+	case GST_TRIGGER_RISING:
+	case GST_TRIGGER_FALLING:
+		// in live mode the camera captures a frame for each edge
+		UEYEEXECANDCHECK(is_SetExternalTrigger(src->hCam, src->trigger_mode == GST_TRIGGER_RISING ? IS_SET_TRIGGER_LO_HI : IS_SET_TRIGGER_HI_LO));
+		UEYEEXECANDCHECK(is_CaptureVideo(src->hCam, IS_DONT_WAIT));
+		break;
+	case GST_TRIGGER_FREERUN:
+	default:
+		UEYEEXECANDCHECK(is_SetExternalTrigger(src->hCam, IS_SET_TRIGGER_OFF));
+		UEYEEXECANDCHECK(is_CaptureVideo(src->hCam, IS_FORCE_VIDEO_START));
+		break;
+	}
+	GST_OBJECT_LOCK (src);
 	src->acq_started = TRUE;
+	GST_OBJECT_UNLOCK (src);
+	gst_ueye_src_start_capture(src);
+
+	// a new window reads out in a different time
+	gst_ueye_src_check_latency (src);
 
 	return TRUE;
 
@@ -721,238 +2170,1094 @@ gst_ueye_src_set_caps (GstBaseSrc * bsrc, GstCaps * caps)
 	return FALSE;
 }
 
-//  This can override the push class create fn, it is the same as fill above but it forces the creation of a buffer here to copy into.
-#ifdef OVERRIDE_CREATE
-static GstFlowReturn
-gst_ueye_src_create (GstPushSrc * psrc, GstBuffer ** buf)
+static gboolean
+gst_ueye_src_decide_allocation (GstBaseSrc * bsrc, GstQuery * query)
 {
-	GstUEyeSrc *src = GST_UEYE_SRC (psrc);
-	GstMapInfo minfo;
+	// Copied frames go into buffers from a pool, ours unless downstream offers one
+	GstUEyeSrc *src = GST_UEYE_SRC (bsrc);
+	GstBufferPool *pool = NULL;
+	GstStructure *config;
+	GstCaps *caps;
+	guint size, min, max;
+	gboolean update;
 
-	// lock next (raw) image for read access, convert it to the desired
-	// format and unlock it again, so that grabbing can go on
+	gst_query_parse_allocation (query, &caps, NULL);
 
-	// Wait for the next image to be ready
-	INT timeout = 5000.0/src->framerate;  // 5 times the frame period in ms
-	INT nRet = is_WaitEvent(src->hCam, IS_SET_EVENT_FRAME_RECEIVED, timeout);
+	if (gst_query_get_n_allocation_pools (query) > 0) {
+		gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
+		update = TRUE;
+	} else {
+		size = min = max = 0;
+		update = FALSE;
+	}
 
-	if(G_LIKELY(nRet == IS_SUCCESS))
-	{
-		//  successfully returned an image
-		// ----------------------------------------------------------
+	// With video meta, ring memory with the driver's pitch can go downstream as it is
+	// (there is no video meta for video/x-bayer)
+	src->use_video_meta = !GST_UEYE_FORMAT_IS_BAYER (src->format)
+			&& gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+	GST_DEBUG_OBJECT (src, "Downstream %s video meta", src->use_video_meta ? "supports" : "does not support");
+
+	size = MAX (size, src->nHeight * src->gst_stride);
+	min = MAX (min, UEYE_MIN_POOL_BUFFERS);
+	if (max != 0)
+		max = MAX (max, min);
+
+	// A video buffer pool cannot take video/x-bayer caps
+	if (pool != NULL && GST_UEYE_FORMAT_IS_BAYER (src->format) && GST_IS_VIDEO_BUFFER_POOL (pool)) {
+		gst_object_unref (pool);
+		pool = NULL;
+	}
+	if (pool == NULL)
+		pool = GST_UEYE_FORMAT_IS_BAYER (src->format) ? gst_buffer_pool_new () : gst_ueye_buffer_pool_new ();
+
+	config = gst_buffer_pool_get_config (pool);
+	gst_buffer_pool_config_set_params (config, caps, size, min, max);
+	if (src->use_video_meta && gst_buffer_pool_has_option (pool, GST_BUFFER_POOL_OPTION_VIDEO_META))
+		gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+	if (!gst_buffer_pool_set_config (pool, config)) {
+		// Downstream's pool does not like our parameters, use our own
+		GST_DEBUG_OBJECT (src, "Downstream pool rejected the config, using our own pool");
+		gst_object_unref (pool);
+		pool = GST_UEYE_FORMAT_IS_BAYER (src->format) ? gst_buffer_pool_new () : gst_ueye_buffer_pool_new ();
+		config = gst_buffer_pool_get_config (pool);
+		gst_buffer_pool_config_set_params (config, caps, size, min, max);
+		if (src->use_video_meta)
+			gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+		if (!gst_buffer_pool_set_config (pool, config)) {
+			GST_ERROR_OBJECT (src, "Failed to configure the buffer pool");
+			gst_object_unref (pool);
+			return FALSE;
+		}
+	}
 
-		guint i;
+	GST_DEBUG_OBJECT (src, "Using pool %" GST_PTR_FORMAT " with size %u, min %u, max %u", pool, size, min, max);
 
-		// Copy image to buffer in the right way
+	if (update)
+		gst_query_set_nth_allocation_pool (query, 0, pool, size, min, max);
+	else
+		gst_query_add_allocation_pool (query, pool, size, min, max);
 
-		// Create a new buffer for the image
-		*buf = gst_buffer_new_and_alloc (src->nHeight * src->gst_stride);
+	gst_object_unref (pool);
 
-		gst_buffer_map (*buf, &minfo, GST_MAP_WRITE);
+	return TRUE;
+}
 
-		// From the grabber source we get 1 progressive frame
-		// We expect src->vrm_stride = src->gst_stride but use separate vars for safety
+// Running time now, on the pipeline clock, or GST_CLOCK_TIME_NONE if we have no clock yet
+static GstClockTime
+gst_ueye_src_get_running_time (GstUEyeSrc * src)
+{
+	GstClock *clock;
+	GstClockTime now;
 
-		for (i = 0; i < src->nHeight; i++) {
-			memcpy (minfo.data + i * src->gst_stride,
-					src->pcImgMem + i * src->nPitch, src->nPitch);
-		}
+	clock = gst_element_get_clock (GST_ELEMENT (src));
+	if (clock == NULL)
+		return GST_CLOCK_TIME_NONE;
 
-		gst_buffer_unmap (*buf, &minfo);
+	now = gst_clock_get_time (clock);
+	gst_object_unref (clock);
 
-		// If we do not use gst_base_src_set_do_timestamp() we need to add timestamps manually
-		src->last_frame_time += src->duration;   // Get the timestamp for this frame
-		if(!gst_base_src_get_do_timestamp(GST_BASE_SRC(psrc))){
-			GST_BUFFER_PTS(*buf) = src->last_frame_time;  // convert ms to ns
-			GST_BUFFER_DTS(*buf) = src->last_frame_time;  // convert ms to ns
-		}
-		GST_BUFFER_DURATION(*buf) = src->duration;
-//		GST_DEBUG_OBJECT(src, "pts, dts: %" GST_TIME_FORMAT ", duration: %d ms", GST_TIME_ARGS (src->last_frame_time), GST_TIME_AS_MSECONDS(src->duration));
+	return now - gst_element_get_base_time (GST_ELEMENT (src));
+}
 
-		// count frames, and send EOS when required frame number is reached
-		GST_BUFFER_OFFSET(*buf) = src->n_frames;  // from videotestsrc
-		src->n_frames++;
-		GST_BUFFER_OFFSET_END(*buf) = src->n_frames;  // from videotestsrc
-		if (psrc->parent.num_buffers>0)  // If we were asked for a specific number of buffers, stop when complete
-			if (G_UNLIKELY(src->n_frames >= psrc->parent.num_buffers))
-				return GST_FLOW_EOS;
+// Latency of our frames: a buffer is timestamped with the start of its exposure, it arrives after the
+// exposure and the sensor readout (the transfer overlaps the readout). Frames can then wait in the capture
+// queue until it overflows, in freerun that is a frame period each, triggered frames wait as long as they need to.
+static void
+gst_ueye_src_get_latency (GstUEyeSrc * src, GstClockTime * min, GstClockTime * max)
+{
+	gint queued;
 
-		// see, if we had to drop some frames due to data transfer stalls. if so,
-		// output a message
-	}
+	GST_OBJECT_LOCK (src);
+	queued = src->queue ? (gint) src->queue->capacity : src->queue_size;
+	GST_OBJECT_UNLOCK (src);
+
+	g_mutex_lock (&src->params_lock);
+	*min = (GstClockTime) (src->exposure * GST_MSECOND) + src->readout;
+	if (src->trigger_mode == GST_TRIGGER_FREERUN)
+		*max = *min + queued * src->duration;
 	else
-	{
-		// did not return an image. why?
-		// ----------------------------------------------------------
-		switch(nRet)
-		{
-		case IS_TIMED_OUT:
-			GST_ERROR_OBJECT(src, "is_WaitEvent() timed out.");
+		*max = GST_CLOCK_TIME_NONE;
+	g_mutex_unlock (&src->params_lock);
+}
+
+// Tell the pipeline to query the latency again if it has changed since it last did
+static void
+gst_ueye_src_check_latency (GstUEyeSrc * src)
+{
+	GstClockTime min, max;
+	gboolean changed;
+
+	gst_ueye_src_get_latency (src, &min, &max);
+
+	GST_OBJECT_LOCK (src);
+	changed = GST_CLOCK_TIME_IS_VALID (src->latency) && src->latency != min;
+	GST_OBJECT_UNLOCK (src);
+
+	if (changed) {
+		GST_INFO_OBJECT (src, "Latency changed to %" GST_TIME_FORMAT, GST_TIME_ARGS (min));
+		gst_element_post_message (GST_ELEMENT (src), gst_message_new_latency (GST_OBJECT (src)));
+	}
+}
+
+static gboolean
+gst_ueye_src_query (GstBaseSrc * bsrc, GstQuery * query)
+{
+	GstUEyeSrc *src = GST_UEYE_SRC (bsrc);
+	GstClockTime min, max;
+
+	switch (GST_QUERY_TYPE (query)) {
+	case GST_QUERY_LATENCY:
+		// not until the camera is open
+		if (!gst_ueye_src_is_open (src))
+			return FALSE;
+
+		gst_ueye_src_get_latency (src, &min, &max);
+		GST_OBJECT_LOCK (src);
+		src->latency = min;
+		GST_OBJECT_UNLOCK (src);
+
+		GST_DEBUG_OBJECT (src, "Latency min %" GST_TIME_FORMAT " max %" GST_TIME_FORMAT, GST_TIME_ARGS (min), GST_TIME_ARGS (max));
+		gst_query_set_latency (query, TRUE, min, max);
+		return TRUE;
+	default:
+		return GST_BASE_SRC_CLASS (gst_ueye_src_parent_class)->query (bsrc, query);
+	}
+}
+
+// Program the camera parameters changed since the last batch. The capture thread calls this between frames,
+// so the changes land together and the first frame captured after is tagged with the change sequence number.
+static void
+gst_ueye_src_apply_parameters (GstUEyeSrc * src)
+{
+	guint pending, seq;
+	gint pixelclock, gain, blacklevel, rgain, ggain, bgain, hflip, vflip;
+	gdouble exposure, maxframerate, framerate = 0.0;
+	GstClockTime readout = 0;
+	WhiteBalanceType whitebalance;
+
+	g_mutex_lock (&src->apply_lock);
+
+	// Take the batch, new changes can be recorded while we program this one
+	g_mutex_lock (&src->params_lock);
+	pending = src->params_pending;
+	src->params_pending = 0;
+	seq = src->params_seq;
+	pixelclock = src->pixelclock;
+	exposure = src->exposure;
+	maxframerate = src->maxframerate;
+	gain = src->gain;
+	blacklevel = src->blacklevel;
+	rgain = src->rgain;
+	ggain = src->ggain;
+	bgain = src->bgain;
+	hflip = src->hflip;
+	vflip = src->vflip;
+	whitebalance = src->whitebalance;
+	g_mutex_unlock (&src->params_lock);
+
+	if (pending == 0) {
+		g_mutex_unlock (&src->apply_lock);
+		return;
+	}
+
+	GST_DEBUG_OBJECT (src, "Programming parameter changes 0x%x, sequence %u", pending, seq);
+
+	if (pending & UEYE_PARAM_PIXELCLOCK)
+		is_PixelClock(src->hCam, IS_PIXELCLOCK_CMD_SET, (void*)&pixelclock, sizeof(pixelclock));
+	// the frame rate and exposure ranges depend on the pixel clock
+	if (pending & (UEYE_PARAM_PIXELCLOCK | UEYE_PARAM_EXPOSURE))
+		gst_ueye_program_exposure(src, &exposure, maxframerate, &framerate, &readout);
+	if (pending & UEYE_PARAM_GAIN)
+		is_SetHardwareGain(src->hCam, gain, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
+	if (pending & UEYE_PARAM_BLACKLEVEL)
+		is_Blacklevel(src->hCam, IS_BLACKLEVEL_CMD_SET_OFFSET, (void*)&blacklevel, sizeof(blacklevel));
+	if (pending & UEYE_PARAM_RGAIN)
+		is_SetHardwareGain(src->hCam, IS_IGNORE_PARAMETER, rgain, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
+	if (pending & UEYE_PARAM_GGAIN)
+		is_SetHardwareGain(src->hCam, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, ggain, IS_IGNORE_PARAMETER);
+	if (pending & UEYE_PARAM_BGAIN)
+		is_SetHardwareGain(src->hCam, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, bgain);
+	if (pending & UEYE_PARAM_HFLIP)
+		is_SetRopEffect(src->hCam, IS_SET_ROP_MIRROR_LEFTRIGHT, hflip, 0);
+	if (pending & UEYE_PARAM_VFLIP)
+		is_SetRopEffect(src->hCam, IS_SET_ROP_MIRROR_UPDOWN, vflip, 0);
+	if (pending & UEYE_PARAM_WHITEBALANCE)
+		gst_ueye_set_camera_whitebalance(src, whitebalance);
+
+	g_mutex_lock (&src->params_lock);
+	if (pending & (UEYE_PARAM_PIXELCLOCK | UEYE_PARAM_EXPOSURE)) {
+		// keep what the camera actually set, unless there is already a newer request
+		if (!(src->params_pending & UEYE_PARAM_EXPOSURE))
+			src->exposure = exposure;
+		src->framerate = framerate;
+		src->duration = 1000000000.0/framerate;  // frame duration in ns
+		src->readout = readout;
+	}
+	src->params_applied_seq = seq;
+	src->params_applied_time = gst_ueye_src_get_running_time (src);
+	g_mutex_unlock (&src->params_lock);
+
+	g_mutex_unlock (&src->apply_lock);
+
+	// a longer or shorter exposure moves the frames' arrival against their timestamps
+	if (pending & (UEYE_PARAM_PIXELCLOCK | UEYE_PARAM_EXPOSURE))
+		gst_ueye_src_check_latency (src);
+}
+
+// Read the camera parameters back from the camera into the cache the properties return.
+// A parameter with a change still waiting to be programmed keeps the requested value.
+static gboolean
+gst_ueye_src_refresh (GstUEyeSrc * src)
+{
+	gint pixelclock = 0, gain, blacklevel = 0, rgain, ggain, bgain;
+	gdouble exposure = 0.0;
+	guint pending;
+
+	if (!gst_ueye_src_is_open (src)) {
+		GST_DEBUG_OBJECT (src, "No camera to refresh from");
+		return FALSE;
+	}
+
+	// not while a batch is being programmed
+	g_mutex_lock (&src->apply_lock);
+
+	is_PixelClock(src->hCam, IS_PIXELCLOCK_CMD_GET, (void*)&pixelclock, sizeof(pixelclock));
+	is_Exposure(src->hCam, IS_EXPOSURE_CMD_GET_EXPOSURE, (void*)&exposure, sizeof(exposure));
+	gain = is_SetHardwareGain(src->hCam, IS_GET_MASTER_GAIN, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
+	is_Blacklevel(src->hCam, IS_BLACKLEVEL_CMD_GET_OFFSET, (void*)&blacklevel, sizeof(blacklevel));
+	rgain = is_SetHardwareGain(src->hCam, IS_GET_RED_GAIN, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
+	ggain = is_SetHardwareGain(src->hCam, IS_GET_GREEN_GAIN, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
+	bgain = is_SetHardwareGain(src->hCam, IS_GET_BLUE_GAIN, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER, IS_IGNORE_PARAMETER);
+
+	g_mutex_lock (&src->params_lock);
+	pending = src->params_pending;
+	if (!(pending & UEYE_PARAM_PIXELCLOCK))
+		src->pixelclock = pixelclock;
+	if (!(pending & UEYE_PARAM_EXPOSURE))
+		src->exposure = exposure;
+	if (!(pending & UEYE_PARAM_GAIN))
+		src->gain = gain;
+	if (!(pending & UEYE_PARAM_BLACKLEVEL))
+		src->blacklevel = blacklevel;
+	if (!(pending & UEYE_PARAM_RGAIN))
+		src->rgain = rgain;
+	if (!(pending & UEYE_PARAM_GGAIN))
+		src->ggain = ggain;
+	if (!(pending & UEYE_PARAM_BGAIN))
+		src->bgain = bgain;
+	g_mutex_unlock (&src->params_lock);
+
+	g_mutex_unlock (&src->apply_lock);
+
+	GST_DEBUG_OBJECT (src, "Refreshed: pixel clock %d, exposure %.3f ms, gains %d (%d, %d, %d), black level %d",
+			pixelclock, exposure, gain, rgain, ggain, bgain, blacklevel);
+
+	return TRUE;
+}
+
+// Capture thread: dequeue each image as soon as it is ready and queue it for create, so a stall
+// downstream does not stop us taking frames from the camera. The image queue returns it locked so the
+// camera cannot overwrite it, it is unlocked when the pipeline has finished with it, or if it is dropped.
+// The SDK signals that the open camera has gone, unplugged or dropped off the bus by a USB reset.
+// The streaming thread then waits for it to come back, see gst_ueye_src_reconnect.
+static gboolean
+gst_ueye_src_camera_removed (GstUEyeSrc * src)
+{
+	if (is_WaitEvent(src->hCam, IS_SET_EVENT_REMOVE, 0) != IS_SUCCESS)
+		return FALSE;
+
+	GST_WARNING_OBJECT (src, "Camera %s removed", src->camera_serial ? src->camera_serial : "");
+	src->device_lost_time = g_get_monotonic_time ();
+	g_atomic_int_set (&src->device_lost, TRUE);
+
+	return TRUE;
+}
+
+static gpointer
+gst_ueye_src_capture_thread (gpointer data)
+{
+	GstUEyeSrc *src = GST_UEYE_SRC (data);
+	GstUEyeFrame frame, dropped;
+	INT nRet;
+
+	GST_DEBUG_OBJECT (src, "Capture thread started");
+
+	while (!g_atomic_int_get (&src->capture_stop)) {
+		// between frames, program any parameters changed since the last one
+		gst_ueye_src_apply_parameters (src);
+
+		// wait in slices so that we notice being stopped, create times out if no frames come
+		nRet = is_WaitForNextImage(src->hCam, UEYE_CAPTURE_WAIT_SLICE, &frame.pcMem, &frame.nMemId);
+		if (nRet == IS_TIMED_OUT) {
+			if (G_UNLIKELY(gst_ueye_src_camera_removed (src)))
+				break;
+			continue;
+		}
+		// a failed transfer leaves no image in the queue, just wait for the next one
+		// the frame counter gap it leaves is reported with the next frame
+		if (G_UNLIKELY(nRet == IS_CAPTURE_STATUS)) {
+			GST_WARNING_OBJECT(src, "Image transfer failed, waiting for the next image.");
+			continue;
+		}
+		if (G_UNLIKELY(nRet != IS_SUCCESS)) {
+			if (gst_ueye_src_camera_removed (src))
+				break;
+			GST_ERROR_OBJECT(src, "is_WaitForNextImage() failed with a generic error.");
+			g_usleep (UEYE_CAPTURE_WAIT_SLICE * 1000);
+			continue;
+		}
+
+		frame.wait_time = gst_util_get_timestamp ();
+		frame.arrival = gst_ueye_src_get_running_time (src);
+		if (G_UNLIKELY(is_GetImageInfo(src->hCam, frame.nMemId, &frame.info, sizeof(frame.info)) != IS_SUCCESS))
+			memset (&frame.info, 0, sizeof(frame.info));
+
+		switch (gst_ueye_queue_push (src->queue, &frame, src->overflow_policy, &dropped)) {
+		case GST_UEYE_QUEUE_OK:
+			break;
+		case GST_UEYE_QUEUE_DROPPED:
+			GST_LOG_OBJECT (src, "Queue full, dropped frame %" G_GUINT64_FORMAT, (guint64) dropped.info.u64FrameNumber);
+			is_UnlockSeqBuf(src->hCam, dropped.nMemId, dropped.pcMem);
 			break;
 		default:
-			GST_ERROR_OBJECT(src, "is_WaitEvent() failed with a generic error.");
+			// flushing, we are being stopped
+			is_UnlockSeqBuf(src->hCam, frame.nMemId, frame.pcMem);
 			break;
 		}
+	}
+
+	GST_DEBUG_OBJECT (src, "Capture thread stopped");
+
+	return NULL;
+}
+
+// Start the capture thread, with the queue it fills, once the camera is capturing into the ring
+static void
+gst_ueye_src_start_capture (GstUEyeSrc * src)
+{
+	// leave the camera enough buffers to capture into when the queue is full
+	gint size = MAX(1, MIN(src->queue_size, src->allocator->nBuffers - UEYE_MIN_FREE_SEQ_BUFFERS));
+	GstUEyeQueue *queue = gst_ueye_queue_new (size);
+
+	// started while unlocked, create must not wait on it until unlock_stop
+	GST_OBJECT_LOCK (src);
+	if (g_atomic_int_get (&src->unlocking))
+		gst_ueye_queue_set_flushing (queue, TRUE);
+	src->queue = queue;
+	GST_OBJECT_UNLOCK (src);
+
+	g_atomic_int_set (&src->capture_stop, FALSE);
+	g_atomic_int_set (&src->capture_running, TRUE);
+	src->capture_thread = g_thread_new ("ueyesrc-capture", gst_ueye_src_capture_thread, src);
+}
+
+// Stop the capture thread and give the frames still queued back to the ring
+static void
+gst_ueye_src_stop_capture (GstUEyeSrc * src)
+{
+	GstUEyeQueue *queue;
+	GstUEyeFrame frame;
+
+	if (src->capture_thread == NULL)
+		return;
+
+	g_atomic_int_set (&src->capture_stop, TRUE);
+	gst_ueye_queue_set_flushing (src->queue, TRUE);  // wakes a capture thread blocked on a full queue
+	g_thread_join (src->capture_thread);
+	src->capture_thread = NULL;
+	g_atomic_int_set (&src->capture_running, FALSE);
+	// changes recorded after the last batch are programmed by start, or the next capture thread
+
+	GST_OBJECT_LOCK (src);
+	queue = src->queue;
+	src->queue = NULL;
+	GST_OBJECT_UNLOCK (src);
+
+	while (gst_ueye_queue_try_pop (queue, &frame))
+		is_UnlockSeqBuf(src->hCam, frame.nMemId, frame.pcMem);
+	gst_ueye_queue_free (queue);
+}
+
+// Take a frame in software trigger mode, or force one when waiting for an edge on the trigger input
+static gboolean
+gst_ueye_src_trigger (GstUEyeSrc * src)
+{
+	HIDS hCam;
+	TriggerModeType trigger_mode;
+	gboolean started;
+	INT nRet;
+
+	// this runs on the application's thread, while streaming starts, stops or reopens the camera
+	GST_OBJECT_LOCK (src);
+	started = src->camera_open && src->acq_started;
+	hCam = src->hCam;
+	GST_OBJECT_UNLOCK (src);
+
+	g_mutex_lock (&src->params_lock);
+	trigger_mode = src->trigger_mode;
+	g_mutex_unlock (&src->params_lock);
+
+	if (!started || trigger_mode == GST_TRIGGER_FREERUN) {
+		GST_WARNING_OBJECT (src, "Cannot trigger, the camera is not waiting for a trigger");
+		return FALSE;
+	}
+
+	// a software triggered frame must use the parameters set before the trigger
+	if (trigger_mode == GST_TRIGGER_SOFTWARE) {
+		gst_ueye_src_apply_parameters (src);
+		nRet = is_FreezeVideo(hCam, IS_DONT_WAIT);
+	}
+	else
+		nRet = is_ForceTrigger(hCam);
+
+	if (nRet != IS_SUCCESS) {
+		GST_WARNING_OBJECT (src, "Trigger failed with %d", nRet);
+		return FALSE;
+	}
+
+	GST_LOG_OBJECT (src, "Triggered");
+	return TRUE;
+}
+
+// The camera was removed: let go of it, wait up to reconnect-timeout for the same serial number to come back,
+// open it with the settings and caps we had and carry on, the next buffer marked as a discontinuity
+static GstFlowReturn
+gst_ueye_src_reconnect (GstUEyeSrc * src)
+{
+	UEYE_CAMERA_LIST *list;
+	const UEYE_CAMERA_INFO *info;
+	GstCaps *caps;
+	gint64 deadline;
+	GstClockTime downtime;
+	gboolean arrival, opened = FALSE, flushing = FALSE;
+	guint attempts = 0;
+	gchar *serial;
+
+	serial = g_strdup (src->camera_serial);
+	gst_element_post_message (GST_ELEMENT (src),
+			gst_message_new_element (GST_OBJECT (src),
+					gst_structure_new ("ueyesrc-removed", "serial", G_TYPE_STRING, serial, NULL)));
+
+	if (src->reconnect_timeout <= 0 || serial == NULL) {
+		GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND, ("The uEye camera was removed."), (NULL));
+		g_free (serial);
 		return GST_FLOW_ERROR;
 	}
 
+	// Let go of the old handle, the ring memory stays valid for buffers still downstream
+	gst_ueye_src_stop_acquisition(src);
+	is_ExitCamera(src->hCam);
+	gst_ueye_src_set_handle (src, 0);
+	src->cameraPresent = FALSE;
+	g_atomic_int_set (&src->device_lost, FALSE);
+
+	// A camera arriving wakes us, otherwise look for it every slice
+	arrival = is_EnableEvent(0, IS_SET_EVENT_NEW_DEVICE) == IS_SUCCESS;
+	deadline = src->device_lost_time + (gint64) src->reconnect_timeout * 1000;
+	while (!opened && g_get_monotonic_time () < deadline) {
+		// stop, or a flushing seek, while we wait
+		flushing = g_atomic_int_get (&src->unlocking) || GST_PAD_IS_FLUSHING (GST_BASE_SRC_PAD (src));
+		if (flushing)
+			break;
+		if (!arrival || is_WaitEvent(0, IS_SET_EVENT_NEW_DEVICE, UEYE_CAPTURE_WAIT_SLICE) != IS_SUCCESS)
+			g_usleep (UEYE_CAPTURE_WAIT_SLICE * 1000);
+
+		list = gst_ueye_camera_list_new();
+		info = gst_ueye_camera_list_find(list, serial, 0);
+		if (info != NULL && !info->dwInUse) {
+			attempts++;
+			GST_DEBUG_OBJECT (src, "Camera %s is back as device %d, opening it", serial, info->dwDeviceID);
+			g_atomic_int_set (&src->opening, TRUE);
+			opened = gst_ueye_src_init_camera(src, (HIDS) (info->dwDeviceID | IS_USE_DEVICE_ID));
+		}
+		g_free(list);
+	}
+	if (arrival)
+		is_DisableEvent(0, IS_SET_EVENT_NEW_DEVICE);
+
+	if (!opened) {
+		if (!flushing)
+			GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND, ("The uEye camera %s was removed and did not come back within %d ms.",
+					serial, src->reconnect_timeout), ("%u attempts to open it", attempts));
+		g_free (serial);
+		return flushing ? GST_FLOW_FLUSHING : GST_FLOW_ERROR;
+	}
+
+	// Capture again with the caps we had
+	caps = gst_pad_get_current_caps (GST_BASE_SRC_PAD (src));
+	if (caps == NULL || !gst_ueye_src_set_caps (GST_BASE_SRC (src), caps)) {
+		GST_ELEMENT_ERROR (src, STREAM, FORMAT, ("The uEye camera %s could not capture with the caps it had before it was removed.", serial),
+				("caps %" GST_PTR_FORMAT, caps));
+		if (caps != NULL)
+			gst_caps_unref (caps);
+		g_free (serial);
+		return GST_FLOW_NOT_NEGOTIATED;
+	}
+	gst_caps_unref (caps);
+
+	// The camera's clock and frame counter start again, offsets carry on from the last buffer
+	src->have_first_frame = FALSE;
+	src->offset_base = src->n_frames > 0 ? src->last_offset + 1 : 0;
+	src->clock_n_obs = 0;
+	src->clock_obs_idx = 0;
+	src->clock_cand_valid = FALSE;
+	src->clock_calibrated = FALSE;
+	src->discont = TRUE;
+
+	GST_OBJECT_LOCK (src);
+	src->reconnects++;
+	GST_OBJECT_UNLOCK (src);
+
+	downtime = (g_get_monotonic_time () - src->device_lost_time) * GST_USECOND;
+	GST_INFO_OBJECT (src, "Camera %s reconnected after %" GST_TIME_FORMAT, serial, GST_TIME_ARGS (downtime));
+	gst_element_post_message (GST_ELEMENT (src),
+			gst_message_new_element (GST_OBJECT (src),
+					gst_structure_new ("ueyesrc-reconnected",
+							"serial", G_TYPE_STRING, serial,
+							"downtime", G_TYPE_UINT64, downtime,
+							"attempts", G_TYPE_UINT, attempts, NULL)));
+	g_free (serial);
+
 	return GST_FLOW_OK;
 }
-#endif // OVERRIDE_CREATE
 
-// Override the push class fill fn, using the default create and alloc fns.
-// buf is the buffer to fill, it may be allocated in alloc or from a downstream element.
-// Other functions such as deinterlace do not work with this type of buffer.
-#ifdef OVERRIDE_FILL
+// Wait for the next frame from the capture thread, opening the camera again if it is removed meanwhile
 static GstFlowReturn
-gst_ueye_src_fill (GstPushSrc * psrc, GstBuffer * buf_external)
+gst_ueye_src_wait_frame (GstUEyeSrc * src, GstUEyeFrame * frame)
+{
+	GstFlowReturn ret;
+	gint64 end_time, now, timeout;
+	gint retries = 0;
+
+	// triggered frames come when the trigger does, otherwise 5 times the frame period
+	if (src->trigger_mode == GST_TRIGGER_FREERUN)
+		timeout = 5000000.0/src->framerate;  // us
+	else if (src->trigger_timeout > 0)
+		timeout = (gint64) src->trigger_timeout * 1000;
+	else
+		timeout = -1;
+	end_time = timeout >= 0 ? g_get_monotonic_time () + timeout : G_MAXINT64;
+
+	for (;;) {
+		// unlock wakes the queue, this catches an unlock before we got to it
+		if (G_UNLIKELY(g_atomic_int_get (&src->unlocking)))
+			return GST_FLOW_FLUSHING;
+		if (G_UNLIKELY(g_atomic_int_get (&src->device_lost))) {
+			ret = gst_ueye_src_reconnect (src);
+			if (ret != GST_FLOW_OK)
+				return ret;
+			return gst_ueye_src_wait_frame (src, frame);
+		}
+
+		// in slices, so that we notice the camera going
+		now = g_get_monotonic_time ();
+		switch (gst_ueye_queue_pop (src->queue, frame, MIN (end_time, now + UEYE_CAPTURE_WAIT_SLICE * 1000))) {
+		case GST_UEYE_QUEUE_OK:
+			return GST_FLOW_OK;
+		case GST_UEYE_QUEUE_FLUSHING:
+			return GST_FLOW_FLUSHING;
+		case GST_UEYE_QUEUE_TIMEOUT:
+		default:
+			if (g_get_monotonic_time () < end_time)
+				continue;
+			GST_OBJECT_LOCK (src);
+			src->total_timeouts++;
+			GST_OBJECT_UNLOCK (src);
+			// a slow frame is not always a dead camera, wait again as many times as we are allowed
+			if (src->timeout_retries < 0 || retries < src->timeout_retries) {
+				retries++;
+				GST_WARNING_OBJECT(src, "Timed out waiting for an image, waiting again (%d)", retries);
+				end_time = g_get_monotonic_time () + timeout;
+				continue;
+			}
+			GST_ELEMENT_ERROR (src, RESOURCE, READ, ("Timed out waiting for an image from the uEye camera."),
+					("%d times in a row", retries + 1));
+			return GST_FLOW_ERROR;
+		}
+	}
+}
+
+// Take the statistics of the frame about to be pushed, if asked for, from its rows as they now are
+static void
+gst_ueye_src_frame_stats (GstUEyeSrc * src, const guint8 * data, gint stride)
+{
+	src->stats_valid = src->statistics;
+	if (!src->stats_valid)
+		return;
+
+	gst_ueye_stats_frame (&src->stats, src->format, gst_ueye_format_bayer_pattern (&src->SensorInfo),
+			data, stride, src->nWidth, src->nHeight, src->statistics_step);
+}
+
+// Copy a locked ring image into an output buffer
+static void
+gst_ueye_src_copy_frame (GstUEyeSrc * src, char * pcMem, GstBuffer * buf)
 {
-	GstUEyeSrc *src = GST_UEYE_SRC (psrc);
 	GstMapInfo minfo;
-	guint8 *image;
-	VRmImage* p_source_img=0;
-	VRmDWORD frames_dropped=0;
-	VRmBOOL ready=FALSE;
-	GstBuffer ** buf = &buf_external;
+	guint i;
 
-	// lock next (raw) image for read access, convert it to the desired
-	// format and unlock it again, so that grabbing can go on
+	gst_buffer_map (buf, &minfo, GST_MAP_WRITE);
 
-	// Wait for the next image to be ready
-	time_t start_time = time(NULL);
-	do {
-		VRmUsbCamIsNextImageReadyEx(src->device, src->port, &ready);
-		usleep(src->image_poll_time_us);
+	// From the grabber source we get 1 progressive frame
+	// Any gamma or LUT we apply is looked up as we copy, and 10 or 12 bit samples are shifted up
+	if (src->demosaicing) {
+		// Raw sensor data, debayered from the ring straight into the buffer
+		gst_ueye_demosaic_frame (src->demosaic, (const guint8 *) pcMem, src->nPitch, (guint8 *) minfo.data, src->gst_stride,
+				src->lut_mode == GST_UEYE_LUT_SOFTWARE ? src->lut : NULL);
+	}
+	else if (src->nPitch == src->gst_stride) {
+		// Same layout, one contiguous copy
+		if (src->lut_mode == GST_UEYE_LUT_SOFTWARE)
+			gst_ueye_lut_apply ((guint8 *) minfo.data, (guint8 *) pcMem, src->nHeight * src->gst_stride, src->lut);
+		else if (src->sample_shift > 0)
+			gst_ueye_format_left_justify ((guint16 *) minfo.data, (const guint16 *) pcMem, src->nHeight * src->gst_stride / 2, src->sample_shift);
+		else
+			memcpy (minfo.data, pcMem, src->nHeight * src->gst_stride);
 	}
-	while(!ready && (time(NULL)-start_time)<5);  // wait for frame ready or 5 sec timeout
+	else {
+		// Different padding, copy just the valid pixels of each row
+		gsize row = src->nWidth * src->nBytesPerPixel;
 
-	if(G_LIKELY(VRmUsbCamLockNextImageEx2(src->device, src->port, &p_source_img, &frames_dropped, 5000)))
-	{
-		// VRmUsbCamLockNextImageEx2() successfully returned an image
-		// ----------------------------------------------------------
+		for (i = 0; i < src->nHeight; i++) {
+			if (src->lut_mode == GST_UEYE_LUT_SOFTWARE)
+				gst_ueye_lut_apply ((guint8 *) minfo.data + i * src->gst_stride,
+						(guint8 *) pcMem + i * src->nPitch, row, src->lut);
+			else if (src->sample_shift > 0)
+				gst_ueye_format_left_justify ((guint16 *) (minfo.data + i * src->gst_stride),
+						(const guint16 *) (pcMem + i * src->nPitch), row / 2, src->sample_shift);
+			else
+				memcpy (minfo.data + i * src->gst_stride,
+						pcMem + i * src->nPitch, row);
+		}
+	}
+
+	gst_ueye_src_frame_stats (src, minfo.data, src->gst_stride);
 
-		// Get a pointer to the image buffer
-		image = p_source_img->mp_buffer;
+	gst_buffer_unmap (buf, &minfo);
+}
 
-		// Return the pitch, between lines of the image, in bytes.
-		src->vrm_stride = p_source_img->m_pitch;
+// Map the camera's timestamp for a frame onto the pipeline running time.
+// Each frame arrives some transfer time after its device timestamp, so in every interval the frame
+// with the least delay is kept as an observation. A regression through those follows the
+// device clock's offset and drift against the pipeline clock.
+static GstClockTime
+gst_ueye_src_device_to_running_time (GstUEyeSrc * src, GstClockTime device_time, GstClockTime arrival)
+{
+	GstClockTime mapped;
+	gdouble r_squared;
+
+	if (!src->clock_cand_valid || (gint64) (arrival - device_time) < (gint64) (src->clock_cand_running - src->clock_cand_device)) {
+		src->clock_cand_device = device_time;
+		src->clock_cand_running = arrival;
+		if (!src->clock_cand_valid && src->clock_n_obs == 0)
+			src->clock_interval_start = device_time;
+		src->clock_cand_valid = TRUE;
+	}
 
-		guint i, j;
+	if (device_time - src->clock_interval_start >= UEYE_CLOCK_OBSERVATION_INTERVAL) {
+		src->clock_obs[2 * src->clock_obs_idx] = src->clock_cand_device;
+		src->clock_obs[2 * src->clock_obs_idx + 1] = src->clock_cand_running;
+		src->clock_obs_idx = (src->clock_obs_idx + 1) % UEYE_CLOCK_OBSERVATIONS;
+		src->clock_n_obs = MIN (src->clock_n_obs + 1, UEYE_CLOCK_OBSERVATIONS);
+		src->clock_cand_valid = FALSE;
+		src->clock_interval_start = device_time;
+
+		if (src->clock_n_obs >= 2)
+			src->clock_calibrated = gst_calculate_linear_regression (src->clock_obs, src->clock_temp, src->clock_n_obs,
+					&src->clock_num, &src->clock_denom, &src->clock_b, &src->clock_xbase, &r_squared);
+	}
 
-		// Copy image to buffer in the right way
+	if (src->clock_calibrated) {
+		GstClockTime delta;
 
-	    switch (src->avc_readout){
-	    case UEYE_PROPID_GRAB_AVC_READOUT_FRAME:
+		if (device_time >= src->clock_xbase)
+			mapped = src->clock_b + gst_util_uint64_scale (device_time - src->clock_xbase, src->clock_num, src->clock_denom);
+		else {
+			delta = gst_util_uint64_scale (src->clock_xbase - device_time, src->clock_num, src->clock_denom);
+			mapped = src->clock_b > delta ? src->clock_b - delta : 0;
+		}
+	}
+	else {
+		// Until we have a rate, just use the least delay seen so far
+		mapped = device_time + (src->clock_cand_running - src->clock_cand_device);
+	}
 
-			gst_buffer_map (*buf, &minfo, GST_MAP_WRITE);
+	// A frame cannot have been captured after it arrived
+	return MIN (mapped, arrival);
+}
 
-			// From the grabber source we get 2 fields combined, interleave these into the target
-			// i steps through the source line by line, j through the target every other line
-			// use 2 loops, one for each field
-			// We expect src->vrm_stride = src->gst_stride but use separate vars for safety
-			for (i = 0, j=0; i < src->height/2; i++, j+=2) {
-				memcpy (minfo.data + j * src->gst_stride,
-						image + i * src->vrm_stride, src->vrm_stride);
-			}
-			for (i = src->height/2, j=1; i < src->height; i++, j+=2) {
-				memcpy (minfo.data + j * src->gst_stride,
-						image + i * src->vrm_stride, src->vrm_stride);
-			}
+// Tell downstream how many bits of each sample are significant, in a sticky "ueyesrc-bit-depth" event.
+// 10 and 12 bit samples are at the top of the 16, the bits below are 0.
+static void
+gst_ueye_src_push_bit_depth (GstUEyeSrc * src)
+{
+	GstStructure *s;
 
-			gst_buffer_unmap (*buf, &minfo);
+	s = gst_structure_new ("ueyesrc-bit-depth", "bits", G_TYPE_UINT, (guint) src->format->depth, NULL);
+	GST_DEBUG_OBJECT (src, "Sending %" GST_PTR_FORMAT, s);
+	gst_pad_push_event (GST_BASE_SRC_PAD (src), gst_event_new_custom (GST_EVENT_CUSTOM_DOWNSTREAM_STICKY, s));
+}
 
-			break;
-	    case UEYE_PROPID_GRAB_AVC_READOUT_FIELD:
-			if (src->interlace){
-				// From the grabber source we get field by field, copy these into the local buffer
-				// i steps through the source line by line, j through the target every other line
-				// We expect src->vrm_stride = src->gst_stride but use separate vars for safety
+// Tell downstream there is a hole of 'lost' frames before timestamp, and the application how many we have lost
+static void
+gst_ueye_src_report_lost_frames (GstUEyeSrc * src, guint64 lost, GstClockTime timestamp)
+{
+	GstClockTime gap_duration = lost * src->duration;
+	GstClockTime gap_start = timestamp > gap_duration ? timestamp - gap_duration : 0;
+	GstMessage *qos;
 
-				gst_buffer_map (src->local_buffer, &minfo, GST_MAP_WRITE);
+	GST_OBJECT_LOCK (src);
+	src->total_dropped += lost;
+	GST_OBJECT_UNLOCK (src);
 
-				// Check m_image_modifier bits for the field identifier
-				// Start on the first or second row based on this
-				j = p_source_img->m_image_format.m_image_modifier & UEYE_INTERLACED_FIELD0 ? 0 : 1;
+	GST_INFO_OBJECT (src, "Lost %" G_GUINT64_FORMAT " frames, %" G_GUINT64_FORMAT " in total", lost, src->total_dropped);
 
-				for (i = 0; i < src->height; i++, j+=2) {
-					memcpy (minfo.data + j * src->gst_stride,
-							image + i * src->vrm_stride, src->vrm_stride);
-				}
+	gst_pad_push_event (GST_BASE_SRC_PAD (src), gst_event_new_gap (gap_start, gap_duration));
 
-				// Copy the local buffer to the frame buffer
-				gst_buffer_fill(*buf, 0, minfo.data, minfo.size);
+	qos = gst_message_new_qos (GST_OBJECT (src), TRUE, gap_start, gap_start, gap_start, gap_duration);
+	gst_message_set_qos_values (qos, 0, 1.0, 1000000);
+	gst_message_set_qos_stats (qos, GST_FORMAT_BUFFERS, src->n_frames, src->total_dropped);
+	gst_element_post_message (GST_ELEMENT (src), qos);
+}
 
-				gst_buffer_unmap (src->local_buffer, &minfo);
-			}
-			else{
+// Check the camera's frame counter and the SDK transfer counters for frames lost before this one
+static void
+gst_ueye_src_check_lost_frames (GstUEyeSrc * src, GstUEyeFrame * frame, GstClockTime timestamp)
+{
+	UEYE_CAPTURE_STATUS_INFO capture_status;
+	guint64 lost = 0;
+
+	if (G_LIKELY(frame->info.u64FrameNumber != 0)) {
+		if (src->have_first_frame && frame->info.u64FrameNumber > src->last_frame_number + 1)
+			lost = frame->info.u64FrameNumber - src->last_frame_number - 1;
+		src->last_frame_number = frame->info.u64FrameNumber;
+	}
 
-				gst_buffer_map (*buf, &minfo, GST_MAP_WRITE);
+	if (is_CaptureStatus(src->hCam, IS_CAPTURE_STATUS_INFO_CMD_GET, (void*)&capture_status, sizeof(capture_status)) == IS_SUCCESS) {
+		if (G_UNLIKELY(capture_status.dwCapStatusCnt_Total != src->last_capture_status)) {
+			guint failures = capture_status.dwCapStatusCnt_Total - src->last_capture_status;
+
+			GST_OBJECT_LOCK (src);
+			src->total_transfer_failures += failures;
+			GST_OBJECT_UNLOCK (src);
+			GST_WARNING_OBJECT (src, "%u image transfers failed, %u in total", failures, src->total_transfer_failures);
+			src->last_capture_status = capture_status.dwCapStatusCnt_Total;
+			// Without a frame counter, a failed transfer is the best measure of a lost frame
+			if (frame->info.u64FrameNumber == 0)
+				lost = failures;
+		}
+	}
 
-				// From the grabber source we get field by field, copy these into the target
-				// i steps through the source line by line, j through the target
-				// We expect src->vrm_stride = src->gst_stride but use separate vars for safety
-				for (i = 0; i < src->height; i++) {
-					memcpy (minfo.data + i * src->gst_stride,
-							image + i * src->vrm_stride, src->vrm_stride);
-				}
+	// The frame counter already shows frames the queue dropped
+	if (frame->info.u64FrameNumber == 0)
+		lost += frame->queue_dropped;
 
-				gst_buffer_unmap (*buf, &minfo);
-			}
+	if (G_UNLIKELY(lost > 0))
+		gst_ueye_src_report_lost_frames (src, lost, timestamp);
+}
+
+// Post a message with the first frame captured after a parameter change was programmed
+static void
+gst_ueye_src_tag_parameters (GstUEyeSrc * src, GstBuffer * buf, GstClockTime timestamp)
+{
+	guint seq;
+
+	g_mutex_lock (&src->params_lock);
+	seq = src->params_applied_seq;
+	if (G_LIKELY(seq == src->params_tagged_seq || timestamp < src->params_applied_time)) {
+		g_mutex_unlock (&src->params_lock);
+		return;
+	}
+	src->params_tagged_seq = seq;
+	g_mutex_unlock (&src->params_lock);
+
+	GST_DEBUG_OBJECT (src, "Parameter change %u first used by frame %" G_GUINT64_FORMAT, seq, GST_BUFFER_OFFSET(buf));
+	gst_element_post_message (GST_ELEMENT (src),
+			gst_message_new_element (GST_OBJECT (src),
+					gst_structure_new ("ueyesrc-parameters",
+							"sequence", G_TYPE_UINT, seq,
+							"timestamp", G_TYPE_UINT64, timestamp,
+							"offset", G_TYPE_UINT64, GST_BUFFER_OFFSET(buf), NULL)));
+}
+
+// How long from start (or the camera opening going to READY) to the first frame, logged and posted as a message
+static void
+gst_ueye_src_report_startup (GstUEyeSrc * src)
+{
+	GstClockTime startup;
+
+	if (src->startup_begin == 0)
+		return;
+	startup = (g_get_monotonic_time () - src->startup_begin) * GST_USECOND;
+	src->startup_begin = 0;
+
+	GST_OBJECT_LOCK (src);
+	src->startup_time = startup;
+	GST_OBJECT_UNLOCK (src);
+
+	GST_INFO_OBJECT (src, "First frame %" GST_TIME_FORMAT " after start, the camera took %" GST_TIME_FORMAT " to open",
+			GST_TIME_ARGS (startup), GST_TIME_ARGS (src->open_time));
+	gst_element_post_message (GST_ELEMENT (src),
+			gst_message_new_element (GST_OBJECT (src),
+					gst_structure_new ("ueyesrc-startup",
+							"open-time", G_TYPE_UINT64, src->open_time,
+							"first-frame-time", G_TYPE_UINT64, startup,
+							"parameter-set", G_TYPE_STRING, src->parameter_set, NULL)));
+}
+
+// Timestamp and count the frame
+static GstFlowReturn
+gst_ueye_src_finish_buffer (GstUEyeSrc * src, GstBuffer * buf, GstUEyeFrame * frame)
+{
+	GstPushSrc *psrc = GST_PUSH_SRC (src);
+	UEYEIMAGEINFO *info = &frame->info;
+	GstClockTime timestamp;
+
+	// Stamp with the camera's own capture time where we have it, otherwise assume the nominal frame rate,
+	// triggered frames have no frame rate so use the time they arrived
+	if (G_LIKELY(info->u64TimestampDevice != 0 && GST_CLOCK_TIME_IS_VALID(frame->arrival))) {
+		timestamp = gst_ueye_src_device_to_running_time (src, info->u64TimestampDevice * 100, frame->arrival);  // device clock ticks are 0.1 us
+		// keep timestamps increasing while the mapping settles
+		if (src->n_frames > 0 && timestamp <= src->last_frame_time)
+			timestamp = src->last_frame_time + 1;
+	}
+	else if (src->trigger_mode != GST_TRIGGER_FREERUN && GST_CLOCK_TIME_IS_VALID(frame->arrival))
+		timestamp = frame->arrival;
+	else
+		timestamp = src->last_frame_time + src->duration;
+	src->last_frame_time = timestamp;
+
+	// see, if we had to drop some frames due to data transfer stalls. if so,
+	// output a message
+	gst_ueye_src_check_lost_frames (src, frame, timestamp);
 
-	    	break;
-	    default:
-	    	GST_WARNING_OBJECT(src, "Invalid AVC Readout property value");
-	    	break;
-	    }
-
-
-		// We are leaving the buffer metadata timestamps DTS and PTS and the duration as GST_CLOCK_TIME_NONE
-		// indicating they are unknown/undefined
-//		GST_FIXME_OBJECT(src, "time: %f", p_source_img->m_time_stamp);
-//		GST_BUFFER_PTS(*buf) = (GstClockTime)(p_source_img->m_time_stamp * 1000000.0);  // convert ms to ns
-//		GST_BUFFER_DTS(*buf) = (GstClockTime)(p_source_img->m_time_stamp * 1000000.0);  // convert ms to ns
-		GST_BUFFER_DURATION (*buf) = src->duration;
-
-		VRmUsbCamUnlockNextImage(src->device, &p_source_img);
-
-		// count frames, and send EOS when required frame number is reached
-		GST_BUFFER_OFFSET(*buf) = src->n_frames;  // from videotestsrc
-		src->n_frames++;
-		GST_BUFFER_OFFSET_END(*buf) = src->n_frames;  // from videotestsrc
-		if (psrc->parent.num_buffers>0)  // If we were asked for a specific number of buffers, stop when complete
-			if (G_UNLIKELY(src->n_frames >= psrc->parent.num_buffers))
-				return GST_FLOW_EOS;
-
-		// We are leaving the buffer metadata timestamps DTS and PTS and the duration as GST_CLOCK_TIME_NONE
-		// indicating they are unknown/undefined
-
-		// see, if we had to drop some frames due to data transfer stalls. if so,
-		// output a message
-		if (G_UNLIKELY(frames_dropped)) {
-			GST_INFO_OBJECT (src, "Received timeout, %d dropped frames", frames_dropped);
-			src->total_timeouts += frames_dropped;
+	// If we do not use gst_base_src_set_do_timestamp() we need to add timestamps manually
+	if(!gst_base_src_get_do_timestamp(GST_BASE_SRC(psrc))){
+		GST_BUFFER_PTS(buf) = src->last_frame_time;
+		GST_BUFFER_DTS(buf) = src->last_frame_time;
+	}
+	GST_BUFFER_DURATION(buf) = src->trigger_mode == GST_TRIGGER_FREERUN ? src->duration : GST_CLOCK_TIME_NONE;
+//	GST_DEBUG_OBJECT(src, "pts, dts: %" GST_TIME_FORMAT ", duration: %d ms", GST_TIME_ARGS (src->last_frame_time), GST_TIME_AS_MSECONDS(src->duration));
+
+	// Offsets come from the camera's frame counter, so they show any frames the camera or transfer lost
+	if (G_LIKELY(info->u64FrameNumber != 0)) {
+		if (!src->have_first_frame) {
+			src->first_frame_number = info->u64FrameNumber;
+			src->have_first_frame = TRUE;
 		}
+		GST_BUFFER_OFFSET(buf) = src->offset_base + info->u64FrameNumber - src->first_frame_number;
 	}
 	else
-	{
-		// VRmUsbCamLockNextImageEx2() did not return an image. why?
-		// ----------------------------------------------------------
-		switch(VRmUsbCamGetLastErrorCode())
-		{
-		case UEYE_ERROR_CODE_FUNCTION_CALL_TIMEOUT:
-		case UEYE_ERROR_CODE_TRIGGER_TIMEOUT:
-		case UEYE_ERROR_CODE_TRIGGER_STALL:
-			GST_ERROR_OBJECT(src, "VRmUsbCamLockNextImageEx2() failed with %s", VRmUsbCamGetLastError());
-			break;
-		case UEYE_ERROR_CODE_GENERIC_ERROR:
-		default:
-			GST_ERROR_OBJECT(src, "VRmUsbCamLockNextImageEx2() failed with a generic error.");
-			break;
+		GST_BUFFER_OFFSET(buf) = src->n_frames;  // from videotestsrc
+	GST_BUFFER_OFFSET_END(buf) = GST_BUFFER_OFFSET(buf) + 1;
+	src->last_offset = GST_BUFFER_OFFSET(buf);
+
+	// Downstream learns the significant bits of the samples of each new format
+	if (G_UNLIKELY(src->depth_pending)) {
+		gst_ueye_src_push_bit_depth (src);
+		src->depth_pending = FALSE;
+	}
+
+	// The first frame after the camera was removed and opened again
+	if (G_UNLIKELY(src->discont)) {
+		GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+		src->discont = FALSE;
+	}
+
+	// Tell the application which frame is the first captured after a batch of parameter changes
+	gst_ueye_src_tag_parameters (src, buf, timestamp);
+
+	if (G_UNLIKELY(src->n_frames == 0))
+		gst_ueye_src_report_startup (src);
+
+	// count frames, basesrc counts them against num-buffers and sends EOS after the last one is pushed
+	src->n_frames++;
+
+	return GST_FLOW_OK;
+}
+
+// The driver's system time for a frame (local time, to the ms) on the gst_util_get_timestamp clock, as the other
+// times of the timing meta, or NONE
+static GstClockTime
+gst_ueye_src_system_to_monotonic (const UEYETIME * t)
+{
+	GDateTime *dt;
+	gint64 real;
+	GstClockTime now;
+
+	if (t->wYear == 0)
+		return GST_CLOCK_TIME_NONE;
+
+	dt = g_date_time_new_local (t->wYear, t->wMonth, t->wDay, t->wHour, t->wMinute, t->wSecond);
+	if (dt == NULL)
+		return GST_CLOCK_TIME_NONE;
+	real = g_date_time_to_unix (dt) * G_USEC_PER_SEC + t->wMilliseconds * 1000;
+	g_date_time_unref (dt);
+
+	// both clocks now, in us
+	now = gst_util_get_timestamp ();
+	real -= g_get_real_time () - (gint64) (now / GST_USECOND);
+	return real > 0 ? (GstClockTime) real * GST_USECOND : GST_CLOCK_TIME_NONE;
+}
+
+// Record where the frame spent its time on the way to the pipeline, see gstueyetracer.c
+static void
+gst_ueye_src_add_timing_meta (GstUEyeSrc * src, GstBuffer * buf, GstUEyeFrame * frame,
+		GstClockTime dequeue, GstClockTime copy_start, GstClockTime copy_end)
+{
+	GstUEyeTimingMeta *meta = gst_buffer_add_ueye_timing_meta (buf);
+
+	if (G_UNLIKELY(meta == NULL))
+		return;
+
+	if (frame->info.u64TimestampDevice != 0)
+		meta->device = frame->info.u64TimestampDevice * 100;  // 0.1 us ticks
+	meta->driver = gst_ueye_src_system_to_monotonic (&frame->info.TimestampSystem);
+	meta->wait = frame->wait_time;
+	meta->dequeue = dequeue;
+	meta->copy_start = copy_start;
+	meta->copy_end = copy_end;
+	meta->push = gst_util_get_timestamp ();
+}
+
+// Put the frame's statistics on its buffer, and post them at most every statistics-interval ms
+static void
+gst_ueye_src_report_stats (GstUEyeSrc * src, GstBuffer * buf)
+{
+	GstUEyeStatsMeta *meta;
+	GstStructure *s;
+	gint64 now;
+
+	if (!src->stats_valid)
+		return;
+	src->stats_valid = FALSE;
+
+	meta = gst_buffer_add_ueye_stats_meta (buf);
+	if (meta != NULL)
+		meta->stats = src->stats;
+
+	now = g_get_monotonic_time ();
+	if (src->stats_posted != 0 && now - src->stats_posted < (gint64) src->statistics_interval * 1000)
+		return;
+	src->stats_posted = now;
+
+	s = gst_ueye_stats_to_structure (&src->stats, "ueyesrc-statistics");
+	gst_structure_set (s,
+			"timestamp", G_TYPE_UINT64, GST_BUFFER_PTS(buf),
+			"offset", G_TYPE_UINT64, GST_BUFFER_OFFSET(buf), NULL);
+	gst_element_post_message (GST_ELEMENT (src), gst_message_new_element (GST_OBJECT (src), s));
+}
+
+#ifdef OVERRIDE_CREATE
+// Whether the next frame can be pushed in the ring memory itself: the layout matches (or downstream takes the driver's
+// pitch from the video meta) and the driver keeps enough buffers to capture into, besides those queued and downstream
+static gboolean
+gst_ueye_src_can_push_ring (GstUEyeSrc * src)
+{
+	return !src->demosaicing && (src->nPitch == src->gst_stride || src->use_video_meta)
+			&& gst_ueye_allocator_get_outstanding(src->allocator) + gst_ueye_queue_get_depth(src->queue)
+					+ UEYE_MIN_FREE_SEQ_BUFFERS < src->allocator->nBuffers;
+}
+
+//  This overrides the push class create fn, it pushes the ring memory itself when it can and otherwise
+//  fills a buffer from the pool, as the default create would.
+static GstFlowReturn
+gst_ueye_src_create (GstPushSrc * psrc, GstBuffer ** buf)
+{
+	GstUEyeSrc *src = GST_UEYE_SRC (psrc);
+	GstMemory *mem;
+	GstFlowReturn ret;
+	GstUEyeFrame frame;
+	GstClockTime dequeue;
+
+	// Decided before waiting, the frame it waits for is one of those queued or yet to be, and those downstream only go back
+	if (!gst_ueye_src_can_push_ring (src)) {
+		ret = GST_BASE_SRC_CLASS (gst_ueye_src_parent_class)->alloc (GST_BASE_SRC (psrc), src->n_frames, src->nHeight * src->gst_stride, buf);
+		if (G_UNLIKELY(ret != GST_FLOW_OK))
+			return ret;
+
+		ret = gst_ueye_src_fill (psrc, *buf);
+		if (G_UNLIKELY(ret != GST_FLOW_OK)){
+			gst_buffer_unref (*buf);
+			*buf = NULL;
 		}
+		return ret;
+	}
+
+	// lock next (raw) image for read access, it is unlocked when downstream releases it
+	ret = gst_ueye_src_wait_frame(src, &frame);
+	if (G_UNLIKELY(ret != GST_FLOW_OK))
+		return ret;
+	dequeue = gst_util_get_timestamp ();
+
+	mem = gst_ueye_allocator_wrap(src->allocator, frame.pcMem, frame.nMemId, src->nHeight * src->nPitch);
+	if (G_UNLIKELY(mem == NULL)){
+		is_UnlockSeqBuf(src->hCam, frame.nMemId, frame.pcMem);
+		GST_ELEMENT_ERROR (src, RESOURCE, READ, ("The uEye camera returned an image outside its image memory."), (NULL));
 		return GST_FLOW_ERROR;
 	}
 
-	return GST_FLOW_OK;
+	// With no copy to do it in, any gamma or LUT we apply is looked up in place, as is any shift
+	if (src->lut_mode == GST_UEYE_LUT_SOFTWARE)
+		gst_ueye_lut_apply ((guint8 *) frame.pcMem, (guint8 *) frame.pcMem, src->nHeight * src->nPitch, src->lut);
+	else if (src->sample_shift > 0)
+		gst_ueye_format_left_justify ((guint16 *) frame.pcMem, (const guint16 *) frame.pcMem, src->nHeight * src->nPitch / 2, src->sample_shift);
+	gst_ueye_src_frame_stats (src, (const guint8 *) frame.pcMem, src->nPitch);
+
+	*buf = gst_buffer_new ();
+	gst_buffer_append_memory (*buf, mem);
+	if (src->use_video_meta) {
+		gsize offset[GST_VIDEO_MAX_PLANES] = { 0, };
+		gint stride[GST_VIDEO_MAX_PLANES] = { src->nPitch, };
+
+		gst_buffer_add_video_meta_full (*buf, GST_VIDEO_FRAME_FLAG_NONE,
+				GST_VIDEO_INFO_FORMAT (&src->vinfo), src->nWidth, src->nHeight, 1, offset, stride);
+	}
+
+	ret = gst_ueye_src_finish_buffer(src, *buf, &frame);
+	if (G_UNLIKELY(ret != GST_FLOW_OK)){
+		gst_buffer_unref (*buf);
+		*buf = NULL;
+	}
+	else {
+		gst_ueye_src_add_timing_meta (src, *buf, &frame, dequeue, GST_CLOCK_TIME_NONE, GST_CLOCK_TIME_NONE);
+		gst_ueye_src_report_stats (src, *buf);
+	}
+
+	return ret;
+}
+#endif // OVERRIDE_CREATE
+
+// Override the push class fill fn, using the default create and alloc fns.
+// buf is the buffer to fill, it is allocated from the pool set up in decide_allocation.
+#ifdef OVERRIDE_FILL
+static GstFlowReturn
+gst_ueye_src_fill (GstPushSrc * psrc, GstBuffer * buf)
+{
+	GstUEyeSrc *src = GST_UEYE_SRC (psrc);
+	GstFlowReturn ret;
+	GstUEyeFrame frame;
+	GstClockTime dequeue, copy_start, copy_end;
+
+	// lock next (raw) image for read access, copy it
+	// and unlock it again, so that grabbing can go on
+	ret = gst_ueye_src_wait_frame(src, &frame);
+	if (G_UNLIKELY(ret != GST_FLOW_OK))
+		return ret;
+	dequeue = gst_util_get_timestamp ();
+
+	copy_start = dequeue;
+	gst_ueye_src_copy_frame(src, frame.pcMem, buf);
+	copy_end = gst_util_get_timestamp ();
+	is_UnlockSeqBuf(src->hCam, frame.nMemId, frame.pcMem);
+
+	ret = gst_ueye_src_finish_buffer(src, buf, &frame);
+	if (G_LIKELY(ret == GST_FLOW_OK)) {
+		gst_ueye_src_add_timing_meta (src, buf, &frame, dequeue, copy_start, copy_end);
+		gst_ueye_src_report_stats (src, buf);
+	}
+
+	return ret;
 }
 #endif // OVERRIDE_FILL
 
@@ -21,9 +21,17 @@
 #define _GST_UEYE_SRC_H_
 
 #include <gst/base/gstpushsrc.h>
+#include <gst/video/video.h>
 
 #include  <ueye.h>
 
+#include "gstueyememory.h"
+#include "gstueyeformat.h"
+#include "gstueyequeue.h"
+#include "gstueyelut.h"
+#include "gstueyedemosaic.h"
+#include "gstueyestats.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_UEYE_SRC   (gst_ueye_src_get_type())
@@ -32,6 +40,8 @@ G_BEGIN_DECLS
 #define GST_IS_UEYE_SRC(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_UEYE_SRC))
 #define GST_IS_UEYE_SRC_CLASS(obj)   (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_UEYE_SRC))
 
+#define UEYE_CLOCK_OBSERVATIONS 32  // device/pipeline time pairs kept for the clock regression
+
 typedef struct _GstUEyeSrc GstUEyeSrc;
 typedef struct _GstUEyeSrcClass GstUEyeSrcClass;
 
@@ -42,29 +52,72 @@ typedef enum
 	GST_WB_AUTO
 } WhiteBalanceType;
 
+// Camera parameters waiting to be programmed, see gst_ueye_src_apply_parameters
+typedef enum
+{
+	UEYE_PARAM_PIXELCLOCK = (1 << 0),
+	UEYE_PARAM_EXPOSURE = (1 << 1),  // also the frame rate
+	UEYE_PARAM_GAIN = (1 << 2),
+	UEYE_PARAM_BLACKLEVEL = (1 << 3),
+	UEYE_PARAM_RGAIN = (1 << 4),
+	UEYE_PARAM_GGAIN = (1 << 5),
+	UEYE_PARAM_BGAIN = (1 << 6),
+	UEYE_PARAM_HFLIP = (1 << 7),
+	UEYE_PARAM_VFLIP = (1 << 8),
+	UEYE_PARAM_WHITEBALANCE = (1 << 9)
+} UEyeParamFlags;
+
+typedef enum
+{
+	GST_TRIGGER_FREERUN,
+	GST_TRIGGER_SOFTWARE,
+	GST_TRIGGER_RISING,
+	GST_TRIGGER_FALLING
+} TriggerModeType;
+
 struct _GstUEyeSrc
 {
   GstPushSrc base_ueye_src;
 
   // device
-  HIDS hCam;  // device handle
+  HIDS hCam;  // device handle, set under the object lock, other threads test camera_open rather than it
+  gboolean camera_open;  // hCam is initialised and its sensor info and AOI limits read, under the object lock
   gboolean cameraPresent;
   SENSORINFO SensorInfo;  // device sensor information
-  char *pcImgMem;  // pointer to the allocated image memory the device driver is using
-  int lMemId;  // ID of the allocated memory
+  guint sensor_depths;  // mask of the sample depths (1 << bits) the sensor can deliver
+  gchar *camera_serial;  // serial number of the open camera, opened again after it is removed
+  GstUEyeAllocator *allocator;  // owns the ring of image memories the device driver captures into (SDK sequence)
   INT nWidth;
   INT nHeight;
   INT nBitsPerPixel;
   INT nBytesPerPixel;
   INT nPitch;   // Stride in bytes between lines
   INT nImageSize;  // Image size in bytes
+  IS_SIZE_2D aoi_min, aoi_max, aoi_inc;  // sensor AOI size limits and step, with the current binning
+  gint binning_factor;  // sensor pixels across each image pixel, binned and subsampled as programmed
+  IS_POINT_2D aoi_pos_inc;  // sensor AOI position step
 
   gint gst_stride;  // Stride/pitch for the GStreamer buffer
+  const GstUEyeFormat *format;  // negotiated output format and the SDK colour mode for it
+  GstVideoInfo vinfo;  // negotiated output format, not valid for raw Bayer
+  gboolean use_video_meta;  // downstream understands GstVideoMeta, so we can push buffers with the driver's pitch
+  GstUEyeLutMode lut_mode;  // where the gamma or LUT curve is applied
+  guint8 lut[GST_UEYE_LUT_SIZE];  // the curve, when we apply it
+  GstUEyeDemosaic *demosaic;  // our Bayer demosaic and its threads, while the camera is open
+  gboolean demosaicing;  // the SDK delivers raw sensor data that we demosaic into the negotiated format
+  guint sample_shift;  // bits to shift 10 or 12 bit samples up by as they are copied, 0 to leave them
+  gboolean depth_pending;  // the bit depth event is sent before the next buffer
 
   // gst properties
+  gint device_id;  // SDK device id of the camera to open, 0 for the first usable camera
+  gchar *serial;  // serial number of the camera to open, takes precedence over device_id
+  gint num_buffers_sdk;
+  gint queue_size;
+  GstUEyeOverflowPolicy overflow_policy;
   gint pixelclock;
   gdouble exposure;
   gdouble framerate;
+  gdouble fixed_framerate;  // set by caps, 0 when the frame rate follows the exposure
   gdouble maxframerate;
   gint gain;
   gint blacklevel;
@@ -72,21 +125,99 @@ struct _GstUEyeSrc
   gint ggain;
   gint bgain;
   gint binning;
+  gint subsampling;
+  gint aoi_x;
+  gint aoi_y;
+  gint aoi_width;  // 0 for any size, chosen by caps negotiation
+  gint aoi_height;
   gint vflip;
   gint hflip;
   WhiteBalanceType whitebalance;
+  TriggerModeType trigger_mode;
+  gdouble gamma;
+  gchar *lut_file;
+  GstUEyeDemosaicMethod demosaic_method;
+  gint demosaic_threads;  // 0 for one per processor
+  gint trigger_timeout;  // ms to wait for a triggered frame, 0 to wait for ever
+  gint reconnect_timeout;  // ms to wait for a removed camera to come back, 0 to fail straight away
+  gint timeout_retries;  // frame waits that may time out in a row, -1 for no limit
+  gchar *parameter_set;  // "eeprom" or an .ini file loaded when the camera is opened, NULL to program every property
+  gboolean statistics;  // take frame statistics for the buffer meta and messages
+  gint statistics_step;  // every step'th pixel of every step'th row
+  gint statistics_interval;  // ms between ueyesrc-statistics messages, 0 for every frame
+
+  // opening the camera, in the background from NULL to READY
+  GThread *open_thread;
+  volatile gint opening;  // parameters set meanwhile are programmed when it has finished
+  gchar *open_serial;  // the camera that was asked for when it was opened
+  gint open_device_id;
+  gint64 startup_begin;  // monotonic us the camera started to open, 0 once the first frame is reported
+  GstClockTime open_time;  // how long opening and programming the camera took
+  GstClockTime startup_time;  // start of opening to the first frame, under the object lock
+
+  // capture thread, dequeues frames from the SDK into the queue that create pops from
+  GThread *capture_thread;
+  volatile gint capture_stop;
+  volatile gint capture_running;
+  volatile gint unlocking;  // between unlock and unlock_stop, create returns FLUSHING
+  volatile gint device_lost;  // the capture thread saw the camera removed, the streaming thread reconnects
+  gint64 device_lost_time;  // monotonic us it was removed
+
+  // camera parameter changes, recorded by set_property and programmed as a batch between frames
+  GMutex params_lock;  // protects the parameter properties and the fields below
+  GMutex apply_lock;  // one batch is programmed at a time
+  guint params_pending;  // UEyeParamFlags
+  guint params_set;  // UEyeParamFlags of the properties that have been set, programmed over a parameter set
+  gboolean binning_set;  // binning or subsampling has been set
+  guint params_seq;  // counts parameter changes
+  guint params_applied_seq;  // the change the camera has been programmed up to
+  GstClockTime params_applied_time;  // running time it was programmed
+  guint params_tagged_seq;  // last change reported with the first frame to use it
+  gboolean resize_pending;  // binning or subsampling changed, programmed when the streaming thread renegotiates
+  GstUEyeQueue *queue;  // set and cleared under the object lock
 
   // stream
-  gboolean acq_started;
+  gboolean acq_started;  // set under the object lock, the trigger signal tests it from the application thread
   gint n_frames;
   gint total_timeouts;
   GstClockTime duration;
+  GstClockTime readout;  // sensor readout time, the shortest frame time
+  GstClockTime latency;  // minimum latency the pipeline was last told, NONE before the first query
   GstClockTime last_frame_time;
+  gboolean have_first_frame;
+  UINT64 first_frame_number;  // camera frame counter of the first frame, buffer offsets count from here
+  UINT64 last_frame_number;
+  guint64 offset_base;  // buffer offset of the camera's first frame, moves on when the camera is opened again
+  guint64 last_offset;
+  gboolean discont;  // the next buffer follows a reconnection
+  GstUEyeStats stats;  // of the frame being pushed, when stats_valid
+  gboolean stats_valid;
+  gint64 stats_posted;  // monotonic us of the last ueyesrc-statistics message, 0 for none yet
+  guint reconnects;  // under the object lock
+  guint64 total_dropped;  // frames missing from the camera's frame counter
+  guint total_transfer_failures;  // failed transfers reported by the SDK capture status
+  DWORD last_capture_status;  // SDK capture status total at the last frame
+
+  // device clock to pipeline running time mapping
+  GstClockTime clock_obs[2 * UEYE_CLOCK_OBSERVATIONS];  // (device, running time) pairs, least delayed frame of each interval
+  GstClockTime clock_temp[2 * UEYE_CLOCK_OBSERVATIONS];  // scratch for the regression
+  guint clock_n_obs;
+  guint clock_obs_idx;
+  GstClockTime clock_interval_start;  // device time the current observation interval started
+  GstClockTime clock_cand_device;  // least delayed frame in the current interval
+  GstClockTime clock_cand_running;
+  gboolean clock_cand_valid;
+  gboolean clock_calibrated;
+  GstClockTime clock_xbase, clock_b, clock_num, clock_denom;  // running = b + (device - xbase) * num / denom
 };
 
 struct _GstUEyeSrcClass
 {
   GstPushSrcClass base_ueye_src_class;
+
+  // action signals
+  gboolean (*trigger) (GstUEyeSrc * src);
+  gboolean (*refresh) (GstUEyeSrc * src);
 };
 
 GType gst_ueye_src_get_type (void);
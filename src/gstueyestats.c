@@ -0,0 +1,213 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ *
+ * Author P Barber
+ */
+// Frame statistics for exposure control downstream: a histogram, the mean, minimum, maximum and the
+// fraction of saturated samples of each channel, from the pixels on a grid.
+//
+// They are taken from the frame as it is pushed, just after it was copied (or shifted or looked up in place),
+// so the rows read are the ones just written. A grid step of 4 or more reads a small part of the frame.
+// Raw Bayer is sampled a 2x2 cell at a time for the red, (first) green and blue of each cell.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstueyestats.h"
+
+// Where a channel's sample is in a pixel, or in a 2x2 Bayer cell
+typedef struct
+{
+	gint row;  // 0 or 1, the row of the cell
+	gint offset;  // bytes into the pixel
+} UEyeStatsSample;
+
+// The layout of the samples we take, FALSE for a format we do not know
+static gboolean
+gst_ueye_stats_layout (const GstUEyeFormat * format, const gchar * pattern, UEyeStatsSample * samples,
+		guint * n_channels, gint * pixel, gint * cell)
+{
+	static const gchar colours[] = "rgb";
+	gint c, i;
+
+	memset (samples, 0, GST_UEYE_STATS_MAX_CHANNELS * sizeof (UEyeStatsSample));
+	*cell = 1;
+	*n_channels = 3;
+
+	if (GST_UEYE_FORMAT_IS_BAYER (format)) {
+		*pixel = format->nBitsPerPixel / 8;
+		*cell = 2;
+		for (c = 0; c < 3; c++) {
+			for (i = 0; i < 4 && pattern[i] != colours[c]; i++)
+				;
+			if (i == 4)
+				return FALSE;
+			samples[c].row = i / 2;
+			samples[c].offset = (i % 2) * *pixel;
+		}
+		return TRUE;
+	}
+
+	switch (format->format) {
+	case GST_VIDEO_FORMAT_BGR:
+	case GST_VIDEO_FORMAT_BGRx:
+		*pixel = format->format == GST_VIDEO_FORMAT_BGR ? 3 : 4;
+		samples[0].offset = 2;
+		samples[1].offset = 1;
+		samples[2].offset = 0;
+		return TRUE;
+	case GST_VIDEO_FORMAT_RGB:
+		*pixel = 3;
+		samples[0].offset = 0;
+		samples[1].offset = 1;
+		samples[2].offset = 2;
+		return TRUE;
+	case GST_VIDEO_FORMAT_UYVY:
+		// the luma of each pixel
+		*pixel = 2;
+		*n_channels = 1;
+		samples[0].offset = 1;
+		return TRUE;
+	case GST_VIDEO_FORMAT_GRAY8:
+	case GST_VIDEO_FORMAT_GRAY16_LE:
+		*pixel = format->nBitsPerPixel / 8;
+		*n_channels = 1;
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+// Statistics of a frame in the negotiated format, from every step'th pixel of every step'th row.
+// pattern is the video/x-bayer pattern of raw Bayer, where step is made even to keep the Bayer phase.
+void
+gst_ueye_stats_frame (GstUEyeStats * stats, const GstUEyeFormat * format, const gchar * pattern,
+		const guint8 * data, gint stride, gint width, gint height, gint step)
+{
+	UEyeStatsSample samples[GST_UEYE_STATS_MAX_CHANNELS];
+	gboolean wide = FALSE;
+	gint pixel, cell, x, y;
+	guint c, shift, n = 0;
+
+	memset (stats, 0, sizeof (*stats));
+	if (!gst_ueye_stats_layout (format, pattern, samples, &stats->n_channels, &pixel, &cell)) {
+		stats->n_channels = 0;
+		return;
+	}
+
+	if (cell == 2)
+		step = GST_ROUND_UP_2 (step);
+	stats->step = step;
+
+	// 16 bit samples have been shifted up, so the top code has the bits below the depth clear
+	if (format->nBitsPerPixel == 16 && format->format != GST_VIDEO_FORMAT_UYVY) {
+		wide = TRUE;
+		shift = GST_UEYE_FORMAT_SHIFT (format);
+		stats->saturation = (0xffff >> shift) << shift;
+	}
+	else
+		stats->saturation = 0xff;
+
+	for (c = 0; c < stats->n_channels; c++)
+		stats->channel[c].min = G_MAXUINT;
+
+	for (y = 0; y + cell <= height; y += step) {
+		const guint8 *line = data + (gsize) y * stride;
+
+		for (x = 0; x + cell <= width; x += step) {
+			const guint8 *p = line + x * pixel;
+
+			n++;
+			for (c = 0; c < stats->n_channels; c++) {
+				GstUEyeStatsChannel *ch = &stats->channel[c];
+				const guint8 *s = p + samples[c].row * stride + samples[c].offset;
+				guint v = wide ? GST_READ_UINT16_LE (s) : *s;
+
+				ch->histogram[wide ? v >> 8 : v]++;
+				ch->sum += v;
+				ch->min = MIN (ch->min, v);
+				ch->max = MAX (ch->max, v);
+				ch->saturated += v >= stats->saturation;
+			}
+		}
+	}
+
+	for (c = 0; c < stats->n_channels; c++) {
+		stats->channel[c].count = n;
+		if (n == 0)
+			stats->channel[c].min = 0;
+	}
+}
+
+// A structure with arrays of the mean, min, max, saturated fraction and histogram, one entry for each channel
+GstStructure *
+gst_ueye_stats_to_structure (const GstUEyeStats * stats, const gchar * name)
+{
+	GValue mean = G_VALUE_INIT, min = G_VALUE_INIT, max = G_VALUE_INIT;
+	GValue saturated = G_VALUE_INIT, histograms = G_VALUE_INIT;
+	GValue v = G_VALUE_INIT;
+	GstStructure *s;
+	guint c, i;
+
+	g_value_init (&mean, GST_TYPE_ARRAY);
+	g_value_init (&min, GST_TYPE_ARRAY);
+	g_value_init (&max, GST_TYPE_ARRAY);
+	g_value_init (&saturated, GST_TYPE_ARRAY);
+	g_value_init (&histograms, GST_TYPE_ARRAY);
+
+	for (c = 0; c < stats->n_channels; c++) {
+		const GstUEyeStatsChannel *ch = &stats->channel[c];
+		GValue histogram = G_VALUE_INIT;
+
+		g_value_init (&v, G_TYPE_DOUBLE);
+		g_value_set_double (&v, ch->count > 0 ? (gdouble) ch->sum / ch->count : 0.0);
+		gst_value_array_append_value (&mean, &v);
+		g_value_set_double (&v, ch->count > 0 ? (gdouble) ch->saturated / ch->count : 0.0);
+		gst_value_array_append_value (&saturated, &v);
+		g_value_unset (&v);
+
+		g_value_init (&v, G_TYPE_UINT);
+		g_value_set_uint (&v, ch->min);
+		gst_value_array_append_value (&min, &v);
+		g_value_set_uint (&v, ch->max);
+		gst_value_array_append_value (&max, &v);
+
+		g_value_init (&histogram, GST_TYPE_ARRAY);
+		for (i = 0; i < GST_UEYE_STATS_BINS; i++) {
+			g_value_set_uint (&v, ch->histogram[i]);
+			gst_value_array_append_value (&histogram, &v);
+		}
+		g_value_unset (&v);
+		gst_value_array_append_and_take_value (&histograms, &histogram);
+	}
+
+	s = gst_structure_new (name,
+			"channels", G_TYPE_UINT, stats->n_channels,
+			"step", G_TYPE_UINT, stats->step,
+			"samples", G_TYPE_UINT, stats->n_channels > 0 ? stats->channel[0].count : 0, NULL);
+	gst_structure_take_value (s, "mean", &mean);
+	gst_structure_take_value (s, "min", &min);
+	gst_structure_take_value (s, "max", &max);
+	gst_structure_take_value (s, "saturated", &saturated);
+	gst_structure_take_value (s, "histogram", &histograms);
+
+	return s;
+}
@@ -0,0 +1,36 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _GST_UEYE_STATS_H_
+#define _GST_UEYE_STATS_H_
+
+#include <gst/gst.h>
+
+#include "gstueyeformat.h"
+#include "gstueyemeta.h"
+
+G_BEGIN_DECLS
+
+void gst_ueye_stats_frame (GstUEyeStats * stats, const GstUEyeFormat * format, const gchar * pattern,
+		const guint8 * data, gint stride, gint width, gint height, gint step);
+GstStructure *gst_ueye_stats_to_structure (const GstUEyeStats * stats, const gchar * name);
+
+G_END_DECLS
+
+#endif
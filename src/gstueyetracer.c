@@ -0,0 +1,281 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ *
+ * Author P Barber
+ */
+// Tracer for the capture timing of ueyesrc frames, from the GstUEyeTimingMeta on each buffer it pushes.
+// Every interval (seconds, default 10) and at exit, it logs a record per stage with the count, min, mean
+// and max, and a histogram of the times in powers of 2 us:
+//
+// GST_TRACERS="ueyetiming(interval=5)" GST_DEBUG=GST_TRACER:7 gst-launch-1.0 ueyesrc ! ...
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstueyetracer.h"
+#include "gstueyemeta.h"
+#include "gstueyesrc.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_ueye_tracer_debug);
+#define GST_CAT_DEFAULT gst_ueye_tracer_debug
+
+#define UEYE_TRACER_DEFAULT_INTERVAL 10  // s
+
+G_DEFINE_TYPE (GstUEyeTracer, gst_ueye_tracer, GST_TYPE_TRACER);
+
+static GstTracerRecord *tr_timing;
+static GQuark pad_quark;  // our GstUEyeTracerPad on each ueyesrc pad
+
+static const gchar *stage_names[GST_UEYE_N_STAGES] = {
+	"device-interval", "driver", "queue", "copy", "create", "basesrc", "downstream", "total"
+};
+
+// What we remember between hooks for each ueyesrc pad, kept on the pad and freed with it
+typedef struct
+{
+	GstClockTime push_start;  // the push in progress (gst_util_get_timestamp), NONE if there is none
+	GstClockTime last_device;  // camera timestamp of the previous frame
+} GstUEyeTracerPad;
+
+static void
+gst_ueye_tracer_add (GstUEyeTracer * self, GstUEyeTracerStage stage, GstClockTime start, GstClockTime end)
+{
+	GstUEyeTracerHistogram *h = &self->stages[stage];
+	GstClockTime t;
+	guint64 us;
+	gint bucket = 0;
+
+	if (!GST_CLOCK_TIME_IS_VALID (start) || !GST_CLOCK_TIME_IS_VALID (end) || end < start)
+		return;
+
+	t = end - start;
+	for (us = t / GST_USECOND; us > 0 && bucket < GST_UEYE_TRACER_BUCKETS - 1; us >>= 1)
+		bucket++;
+
+	h->buckets[bucket]++;
+	if (h->count == 0 || t < h->min)
+		h->min = t;
+	if (t > h->max)
+		h->max = t;
+	h->sum += t;
+	h->count++;
+}
+
+// Log the histograms and start new ones, called with the lock
+static void
+gst_ueye_tracer_dump (GstUEyeTracer * self)
+{
+	gint i, b;
+
+	for (i = 0; i < GST_UEYE_N_STAGES; i++) {
+		GstUEyeTracerHistogram *h = &self->stages[i];
+		GString *hist;
+
+		if (h->count == 0)
+			continue;
+
+		// "lower bound in us:count" of each bucket used
+		hist = g_string_new (NULL);
+		for (b = 0; b < GST_UEYE_TRACER_BUCKETS; b++) {
+			if (h->buckets[b] == 0)
+				continue;
+			g_string_append_printf (hist, "%s%u:%" G_GUINT64_FORMAT, hist->len ? " " : "",
+					b == 0 ? 0 : 1u << (b - 1), h->buckets[b]);
+		}
+
+		gst_tracer_record_log (tr_timing, stage_names[i], h->count, h->min, h->sum / h->count, h->max, hist->str);
+		g_string_free (hist, TRUE);
+	}
+
+	memset (self->stages, 0, sizeof (self->stages));
+}
+
+static GstUEyeTracerPad *
+gst_ueye_tracer_get_pad (GstUEyeTracer * self, GstPad * pad)
+{
+	GstUEyeTracerPad *p = g_object_get_qdata (G_OBJECT (pad), pad_quark);
+
+	if (p == NULL) {
+		p = g_new (GstUEyeTracerPad, 1);
+		p->push_start = GST_CLOCK_TIME_NONE;
+		p->last_device = GST_CLOCK_TIME_NONE;
+		g_object_set_qdata_full (G_OBJECT (pad), pad_quark, p, g_free);
+	}
+
+	return p;
+}
+
+// Only the buffers ueyesrc pushes, elements downstream may copy the meta with the buffer
+static gboolean
+gst_ueye_tracer_is_ueye_pad (GstPad * pad)
+{
+	GstObject *parent = GST_OBJECT_PARENT (pad);
+
+	return parent != NULL && GST_IS_UEYE_SRC (parent) && GST_PAD_IS_SRC (pad);
+}
+
+// The meta times are gst_util_get_timestamp, the hooks' ts counts from the start of tracing,
+// so the stages are timed with gst_util_get_timestamp here too and ts only paces the dumps
+static void
+do_push_buffer_pre (GstUEyeTracer * self, GstClockTime ts, GstPad * pad, GstBuffer * buffer)
+{
+	GstUEyeTimingMeta *meta;
+	GstUEyeTracerPad *p;
+	GstClockTime now = gst_util_get_timestamp ();
+
+	if (!gst_ueye_tracer_is_ueye_pad (pad))
+		return;
+	meta = gst_buffer_get_ueye_timing_meta (buffer);
+	if (meta == NULL)
+		return;
+
+	g_mutex_lock (&self->lock);
+	p = gst_ueye_tracer_get_pad (self, pad);
+	gst_ueye_tracer_add (self, GST_UEYE_STAGE_DEVICE_INTERVAL, p->last_device, meta->device);
+	gst_ueye_tracer_add (self, GST_UEYE_STAGE_DRIVER, meta->driver, meta->wait);
+	gst_ueye_tracer_add (self, GST_UEYE_STAGE_QUEUE, meta->wait, meta->dequeue);
+	gst_ueye_tracer_add (self, GST_UEYE_STAGE_COPY, meta->copy_start, meta->copy_end);
+	gst_ueye_tracer_add (self, GST_UEYE_STAGE_CREATE, meta->dequeue, meta->push);
+	gst_ueye_tracer_add (self, GST_UEYE_STAGE_BASESRC, meta->push, now);
+	gst_ueye_tracer_add (self, GST_UEYE_STAGE_TOTAL, GST_CLOCK_TIME_IS_VALID (meta->driver) ? meta->driver : meta->wait, now);
+	p->last_device = meta->device;
+	p->push_start = now;
+
+	if (!GST_CLOCK_TIME_IS_VALID (self->last_dump))
+		self->last_dump = ts;
+	else if (ts - self->last_dump >= self->interval) {
+		gst_ueye_tracer_dump (self);
+		self->last_dump = ts;
+	}
+	g_mutex_unlock (&self->lock);
+}
+
+static void
+do_push_buffer_post (GstUEyeTracer * self, GstClockTime ts, GstPad * pad, GstFlowReturn res)
+{
+	GstUEyeTracerPad *p;
+	GstClockTime now;
+
+	if (!gst_ueye_tracer_is_ueye_pad (pad))
+		return;
+	now = gst_util_get_timestamp ();
+
+	g_mutex_lock (&self->lock);
+	p = g_object_get_qdata (G_OBJECT (pad), pad_quark);
+	if (p != NULL && GST_CLOCK_TIME_IS_VALID (p->push_start)) {
+		gst_ueye_tracer_add (self, GST_UEYE_STAGE_DOWNSTREAM, p->push_start, now);
+		p->push_start = GST_CLOCK_TIME_NONE;
+	}
+	g_mutex_unlock (&self->lock);
+}
+
+static void
+gst_ueye_tracer_constructed (GObject * object)
+{
+	GstUEyeTracer *self = GST_UEYE_TRACER (object);
+	gchar *params, *tmp;
+	GstStructure *s = NULL;
+	gdouble interval = UEYE_TRACER_DEFAULT_INTERVAL;
+
+	g_object_get (self, "params", &params, NULL);
+	if (params != NULL) {
+		tmp = g_strdup_printf ("ueyetiming,%s", params);
+		s = gst_structure_from_string (tmp, NULL);
+		g_free (tmp);
+		g_free (params);
+	}
+	if (s != NULL) {
+		if (!gst_structure_get_double (s, "interval", &interval)) {
+			gint i;
+
+			if (gst_structure_get_int (s, "interval", &i))
+				interval = i;
+		}
+		gst_structure_free (s);
+	}
+	self->interval = (GstClockTime) (MAX (interval, 0.001) * GST_SECOND);
+
+	G_OBJECT_CLASS (gst_ueye_tracer_parent_class)->constructed (object);
+}
+
+static void
+gst_ueye_tracer_finalize (GObject * object)
+{
+	GstUEyeTracer *self = GST_UEYE_TRACER (object);
+
+	gst_ueye_tracer_dump (self);
+	g_mutex_clear (&self->lock);
+
+	G_OBJECT_CLASS (gst_ueye_tracer_parent_class)->finalize (object);
+}
+
+static void
+gst_ueye_tracer_class_init (GstUEyeTracerClass * klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+	GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "ueyetiming", 0, "uEye capture timing tracer");
+	pad_quark = g_quark_from_static_string ("GstUEyeTracerPad");
+
+	gobject_class->constructed = gst_ueye_tracer_constructed;
+	gobject_class->finalize = gst_ueye_tracer_finalize;
+
+	tr_timing = gst_tracer_record_new ("ueyetiming.class",
+			"stage", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+					"type", G_TYPE_GTYPE, G_TYPE_STRING,
+					"related", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_NONE,
+					"description", G_TYPE_STRING, "stage of the capture pipeline", NULL),
+			"count", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+					"type", G_TYPE_GTYPE, G_TYPE_UINT64,
+					"related", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+					"description", G_TYPE_STRING, "frames in this interval", NULL),
+			"min", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+					"type", G_TYPE_GTYPE, G_TYPE_UINT64,
+					"related", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+					"description", G_TYPE_STRING, "shortest time in ns", NULL),
+			"mean", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+					"type", G_TYPE_GTYPE, G_TYPE_UINT64,
+					"related", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+					"description", G_TYPE_STRING, "mean time in ns", NULL),
+			"max", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+					"type", G_TYPE_GTYPE, G_TYPE_UINT64,
+					"related", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+					"description", G_TYPE_STRING, "longest time in ns", NULL),
+			"histogram", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+					"type", G_TYPE_GTYPE, G_TYPE_STRING,
+					"related", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+					"description", G_TYPE_STRING, "frames from each lower bound in us, buckets are powers of 2", NULL),
+			NULL);
+	GST_OBJECT_FLAG_SET (tr_timing, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+}
+
+static void
+gst_ueye_tracer_init (GstUEyeTracer * self)
+{
+	GstTracer *tracer = GST_TRACER (self);
+
+	g_mutex_init (&self->lock);
+	self->interval = UEYE_TRACER_DEFAULT_INTERVAL * GST_SECOND;
+	self->last_dump = GST_CLOCK_TIME_NONE;
+
+	gst_tracing_register_hook (tracer, "pad-push-pre", G_CALLBACK (do_push_buffer_pre));
+	gst_tracing_register_hook (tracer, "pad-push-post", G_CALLBACK (do_push_buffer_post));
+}
@@ -0,0 +1,80 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _GST_UEYE_TRACER_H_
+#define _GST_UEYE_TRACER_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_UEYE_TRACER   (gst_ueye_tracer_get_type())
+#define GST_UEYE_TRACER(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_UEYE_TRACER,GstUEyeTracer))
+
+#define GST_UEYE_TRACER_BUCKETS 24  // < 1 us, then powers of 2 us up to 4 s and over
+
+typedef struct _GstUEyeTracer GstUEyeTracer;
+typedef struct _GstUEyeTracerClass GstUEyeTracerClass;
+typedef struct _GstUEyeTracerHistogram GstUEyeTracerHistogram;
+
+// The stages of a frame's journey, measured between the times in its GstUEyeTimingMeta
+typedef enum
+{
+  GST_UEYE_STAGE_DEVICE_INTERVAL,  // camera timestamp since the previous frame
+  GST_UEYE_STAGE_DRIVER,  // driver received it until is_WaitForNextImage returned it
+  GST_UEYE_STAGE_QUEUE,  // waiting in the capture queue for create
+  GST_UEYE_STAGE_COPY,  // copying it into a pipeline buffer
+  GST_UEYE_STAGE_CREATE,  // taken from the queue until create returned it
+  GST_UEYE_STAGE_BASESRC,  // create returned it until it was pushed
+  GST_UEYE_STAGE_DOWNSTREAM,  // in the push, downstream's chain functions
+  GST_UEYE_STAGE_TOTAL,  // driver received it until it was pushed
+  GST_UEYE_N_STAGES
+} GstUEyeTracerStage;
+
+struct _GstUEyeTracerHistogram
+{
+  guint64 count;
+  GstClockTime min;
+  GstClockTime max;
+  GstClockTime sum;
+  guint64 buckets[GST_UEYE_TRACER_BUCKETS];
+};
+
+// Collects the timing meta of the frames ueyesrc pushes into a histogram per stage, logged every interval.
+// GST_TRACERS="ueyetiming(interval=10)" GST_DEBUG=GST_TRACER:7
+struct _GstUEyeTracer
+{
+  GstTracer parent;
+
+  GMutex lock;
+  GstClockTime interval;  // between dumps
+  GstClockTime last_dump;
+  GstUEyeTracerHistogram stages[GST_UEYE_N_STAGES];
+};
+
+struct _GstUEyeTracerClass
+{
+  GstTracerClass parent_class;
+};
+
+GType gst_ueye_tracer_get_type (void);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,300 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ *
+ * Author P Barber
+ */
+// Unit tests of ueyesrc, run against the simulated camera in sim/ (configure with --enable-simulator).
+//
+// The simulator is set up from the environment the first time a camera is opened, which the suite does
+// before any test runs, with a sensor small and fast enough to keep the tests quick.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/video/video.h>
+
+#define SIM_WIDTH  640
+#define SIM_HEIGHT 480
+
+// Wait for EOS, dropping the stream's other events
+static void
+wait_for_eos (GstHarness * h)
+{
+	GstEvent *event;
+
+	while ((event = gst_harness_pull_event (h)) != NULL) {
+		GstEventType type = GST_EVENT_TYPE (event);
+
+		gst_event_unref (event);
+		if (type == GST_EVENT_EOS)
+			return;
+	}
+
+	fail ("No EOS");
+}
+
+GST_START_TEST (test_start_stop)
+{
+	GstHarness *h = gst_harness_new ("ueyesrc");
+	GstBuffer *buf;
+	gint i;
+
+	// Open and close the camera without capturing, the open runs in the background
+	for (i = 0; i < 5; i++) {
+		fail_unless (gst_element_set_state (h->element, GST_STATE_READY) != GST_STATE_CHANGE_FAILURE);
+		fail_unless (gst_element_set_state (h->element, GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+	}
+
+	// Capture a frame each time round
+	for (i = 0; i < 5; i++) {
+		fail_unless (gst_element_set_state (h->element, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+		buf = gst_harness_pull (h);
+		fail_unless (buf != NULL);
+		gst_buffer_unref (buf);
+		fail_unless (gst_element_set_state (h->element, GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+	}
+
+	// Stop and start capturing with the camera left open
+	fail_unless (gst_element_set_state (h->element, GST_STATE_READY) != GST_STATE_CHANGE_FAILURE);
+	for (i = 0; i < 5; i++) {
+		fail_unless (gst_element_set_state (h->element, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+		buf = gst_harness_pull (h);
+		fail_unless (buf != NULL);
+		gst_buffer_unref (buf);
+		fail_unless (gst_element_set_state (h->element, GST_STATE_READY) == GST_STATE_CHANGE_SUCCESS);
+	}
+
+	gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+// Every format the simulated colour sensor can deliver, with the bytes per pixel of video/x-bayer
+static const struct
+{
+	const gchar *caps;
+	const gchar *format;
+	gint bayer_bytes;
+} formats[] = {
+	{ "video/x-raw,format=BGR", "BGR", 0 },
+	{ "video/x-raw,format=BGRx", "BGRx", 0 },
+	{ "video/x-raw,format=RGB", "RGB", 0 },
+	{ "video/x-raw,format=UYVY", "UYVY", 0 },
+	{ "video/x-raw,format=GRAY8", "GRAY8", 0 },
+	{ "video/x-raw,format=GRAY16_LE", "GRAY16_LE", 0 },
+	{ "video/x-bayer,format=rggb", "rggb", 1 },
+	{ "video/x-bayer,format=rggb16le", "rggb16le", 2 },
+};
+
+GST_START_TEST (test_caps)
+{
+	GstHarness *h = gst_harness_new ("ueyesrc");
+	GstCaps *caps;
+	GstStructure *s;
+	GstBuffer *buf;
+	gchar *filter;
+	gint width, height;
+	gsize size;
+
+	filter = g_strdup_printf ("%s,width=320,height=240", formats[__i__].caps);
+	gst_harness_set_sink_caps_str (h, filter);
+	g_free (filter);
+	g_object_set (h->element, "num-buffers", 3, NULL);
+	gst_harness_play (h);
+
+	buf = gst_harness_pull (h);
+	fail_unless (buf != NULL);
+
+	caps = gst_pad_get_current_caps (h->sinkpad);
+	fail_unless (caps != NULL);
+	s = gst_caps_get_structure (caps, 0);
+	fail_unless_equals_string (gst_structure_get_string (s, "format"), formats[__i__].format);
+	fail_unless (gst_structure_get_int (s, "width", &width));
+	fail_unless (gst_structure_get_int (s, "height", &height));
+	fail_unless_equals_int (width, 320);
+	fail_unless_equals_int (height, 240);
+
+	// A whole frame in each buffer, Bayer rows are padded to 4 bytes
+	if (formats[__i__].bayer_bytes > 0) {
+		size = GST_ROUND_UP_4 (width * formats[__i__].bayer_bytes) * height;
+	}
+	else {
+		GstVideoInfo vinfo;
+
+		fail_unless (gst_video_info_from_caps (&vinfo, caps));
+		size = GST_VIDEO_INFO_SIZE (&vinfo);
+	}
+	fail_unless_equals_uint64 (gst_buffer_get_size (buf), size);
+
+	gst_caps_unref (caps);
+	gst_buffer_unref (buf);
+	wait_for_eos (h);
+	gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_properties)
+{
+	GstElement *src = gst_element_factory_make ("ueyesrc", NULL);
+	gdouble exposure, gamma;
+	gint gain, pixelclock, queue_size, binning, subsampling, step;
+	gboolean statistics;
+	gchar *serial;
+
+	// What is set is read back, before the camera is open
+	g_object_set (src, "exposure", 12.5, "gain", 40, "pixelclock", 30, "gamma", 2.2,
+			"queue-size", 4, "binning", 2, "statistics", TRUE, "statistics-step", 16, "serial", "4002789012", NULL);
+	g_object_get (src, "exposure", &exposure, "gain", &gain, "pixelclock", &pixelclock, "gamma", &gamma,
+			"queue-size", &queue_size, "binning", &binning, "statistics", &statistics, "statistics-step", &step,
+			"serial", &serial, NULL);
+	fail_unless_equals_float (exposure, 12.5);
+	fail_unless_equals_int (gain, 40);
+	fail_unless_equals_int (pixelclock, 30);
+	fail_unless_equals_float (gamma, 2.2);
+	fail_unless_equals_int (queue_size, 4);
+	fail_unless_equals_int (binning, 2);
+	fail_unless (statistics);
+	fail_unless_equals_int (step, 16);
+	fail_unless_equals_string (serial, "4002789012");
+	g_free (serial);
+
+	// Binning and subsampling of 3 are taken as 2
+	g_object_set (src, "binning", 3, NULL);
+	g_object_get (src, "binning", &binning, NULL);
+	fail_unless_equals_int (binning, 2);
+	g_object_set (src, "binning", 1, "subsampling", 3, NULL);
+	g_object_get (src, "subsampling", &subsampling, NULL);
+	fail_unless_equals_int (subsampling, 2);
+
+	gst_object_unref (src);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_property_ranges)
+{
+	GstElement *src = gst_element_factory_make ("ueyesrc", NULL);
+	GParamSpec *pspec;
+	GValue value = G_VALUE_INIT;
+
+	// Out of range values are clamped to the limits the properties declare
+	pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (src), "gain");
+	fail_unless (pspec != NULL);
+	g_value_init (&value, G_TYPE_INT);
+	g_value_set_int (&value, 1000);
+	fail_unless (g_param_value_validate (pspec, &value));
+	fail_unless_equals_int (g_value_get_int (&value), 100);
+	g_value_unset (&value);
+
+	pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (src), "statistics-step");
+	fail_unless (pspec != NULL);
+	g_value_init (&value, G_TYPE_INT);
+	g_value_set_int (&value, 1000);
+	fail_unless (g_param_value_validate (pspec, &value));
+	fail_unless_equals_int (g_value_get_int (&value), 256);
+	g_value_unset (&value);
+
+	pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (src), "queue-size");
+	fail_unless (pspec != NULL);
+	g_value_init (&value, G_TYPE_INT);
+	g_value_set_int (&value, 0);
+	fail_unless (g_param_value_validate (pspec, &value));
+	fail_unless_equals_int (g_value_get_int (&value), 1);
+	g_value_unset (&value);
+
+	pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (src), "exposure");
+	fail_unless (pspec != NULL);
+	g_value_init (&value, G_TYPE_DOUBLE);
+	g_value_set_double (&value, 0.0);
+	fail_unless (g_param_value_validate (pspec, &value));
+	fail_unless_equals_float (g_value_get_double (&value), 0.01);
+	g_value_unset (&value);
+
+	gst_object_unref (src);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_exposure_clamped)
+{
+	GstHarness *h = gst_harness_new ("ueyesrc");
+	GstBuffer *buf;
+	gdouble exposure;
+
+	// At a fixed 50 fps the exposure is cut to fit in the frame, with room for the sync pulse
+	gst_harness_set_sink_caps_str (h, "video/x-raw,format=GRAY8,width=320,height=240,framerate=50/1");
+	g_object_set (h->element, "exposure", 100.0, NULL);
+	gst_harness_play (h);
+
+	buf = gst_harness_pull (h);
+	fail_unless (buf != NULL);
+	gst_buffer_unref (buf);
+
+	g_object_get (h->element, "exposure", &exposure, NULL);
+	fail_unless (exposure > 0.0 && exposure < 20.0, "exposure %f ms at 50 fps", exposure);
+
+	gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_eos_num_buffers)
+{
+	GstHarness *h = gst_harness_new ("ueyesrc");
+
+	gst_harness_set_sink_caps_str (h, "video/x-raw,format=GRAY8,width=320,height=240");
+	g_object_set (h->element, "num-buffers", 10, "exposure", 1.0, NULL);
+	gst_harness_play (h);
+
+	// EOS comes after the last buffer, so they have all arrived by then
+	wait_for_eos (h);
+	fail_unless_equals_int (gst_harness_buffers_received (h), 10);
+
+	gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+ueyesrc_suite (void)
+{
+	Suite *s = suite_create ("ueyesrc");
+	TCase *tc_chain = tcase_create ("general");
+
+	// A colour camera, read by the simulator when the first camera is opened
+	g_setenv ("UEYE_SIM_WIDTH", G_STRINGIFY (SIM_WIDTH), TRUE);
+	g_setenv ("UEYE_SIM_HEIGHT", G_STRINGIFY (SIM_HEIGHT), TRUE);
+	g_setenv ("UEYE_SIM_SENSOR", "bayer", TRUE);
+	g_setenv ("UEYE_SIM_MAX_FPS", "200", TRUE);
+
+	suite_add_tcase (s, tc_chain);
+	tcase_add_test (tc_chain, test_start_stop);
+	tcase_add_loop_test (tc_chain, test_caps, 0, G_N_ELEMENTS (formats));
+	tcase_add_test (tc_chain, test_properties);
+	tcase_add_test (tc_chain, test_property_ranges);
+	tcase_add_test (tc_chain, test_exposure_clamped);
+	tcase_add_test (tc_chain, test_eos_num_buffers);
+
+	return s;
+}
+
+GST_CHECK_MAIN (ueyesrc);
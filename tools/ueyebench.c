@@ -0,0 +1,208 @@
+/* GStreamer uEye Plugin
+ * Copyright (C) 2014 Gray Cancer Institute
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ *
+ * Author P Barber
+ */
+// Capture benchmark: runs ueyesrc into a fakesink for a number of frames and reports the sustained
+// frame rate, how long create() took per frame and the CPU used per frame.
+//
+// create() latency is the time from the sink being done with one buffer to the next buffer leaving
+// the source, which is the time the streaming thread spent in create(), waiting for the camera included.
+// Exits with 1 if the pipeline fails or stops short, so it can be run by CI against the simulator.
+//
+//   ueyebench --frames=2000 --props="exposure=1" --caps="video/x-raw,format=GRAY8"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#include <gst/gst.h>
+
+static gint frames = 1000;
+static gint warmup = 50;
+static gchar *props = NULL;
+static gchar *caps = NULL;
+
+static GOptionEntry entries[] = {
+	{"frames", 'n', 0, G_OPTION_ARG_INT, &frames, "Frames to measure (default 1000)", "N"},
+	{"warmup", 'w', 0, G_OPTION_ARG_INT, &warmup, "Frames to skip before measuring (default 50)", "N"},
+	{"props", 'p', 0, G_OPTION_ARG_STRING, &props, "Extra ueyesrc properties, e.g. \"exposure=1 num-buffers-sdk=8\"", "PROPS"},
+	{"caps", 'c', 0, G_OPTION_ARG_STRING, &caps, "Caps to capture with (default whatever negotiates)", "CAPS"},
+	{NULL}
+};
+
+typedef struct
+{
+	gint total;  // buffers expected
+	gint pushed;  // buffers that left the source
+	gint handed;  // buffers the sink has finished with
+	gint64 *pushed_time;
+	gint64 *handed_time;
+	gint64 cpu_start;  // us of CPU when the measurement began
+	gint64 cpu_end;
+} Bench;
+
+static gint64
+cpu_time (void)
+{
+	struct rusage usage;
+
+	getrusage (RUSAGE_SELF, &usage);
+	return (gint64) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * G_USEC_PER_SEC
+			+ usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static GstPadProbeReturn
+src_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+	Bench *bench = user_data;
+
+	if (bench->pushed < bench->total)
+		bench->pushed_time[bench->pushed++] = g_get_monotonic_time ();
+
+	return GST_PAD_PROBE_OK;
+}
+
+static void
+sink_handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad, gpointer user_data)
+{
+	Bench *bench = user_data;
+
+	if (bench->handed < bench->total) {
+		bench->handed_time[bench->handed++] = g_get_monotonic_time ();
+		if (bench->handed == warmup)
+			bench->cpu_start = cpu_time ();
+		if (bench->handed == bench->total)
+			bench->cpu_end = cpu_time ();
+	}
+}
+
+static gint
+compare_gint64 (gconstpointer a, gconstpointer b)
+{
+	gint64 x = *(const gint64 *) a, y = *(const gint64 *) b;
+
+	return (x > y) - (x < y);
+}
+
+static gint64
+percentile (const gint64 * sorted, gint n, gint p)
+{
+	return sorted[CLAMP ((n * p + 99) / 100 - 1, 0, n - 1)];
+}
+
+int
+main (int argc, char *argv[])
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	GstElement *pipeline, *src, *sink;
+	GstBus *bus;
+	GstMessage *msg;
+	GstPad *pad;
+	Bench bench = { 0 };
+	gchar *description;
+	gint64 *latency, elapsed;
+	gint i, n;
+	gboolean ok = FALSE;
+
+	context = g_option_context_new ("- ueyesrc capture benchmark");
+	g_option_context_add_main_entries (context, entries, NULL);
+	g_option_context_add_group (context, gst_init_get_option_group ());
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("%s\n", error->message);
+		return 1;
+	}
+	g_option_context_free (context);
+
+	if (frames < 2 || warmup < 1) {
+		g_printerr ("Need at least 2 frames and 1 warmup frame\n");
+		return 1;
+	}
+
+	bench.total = warmup + frames;
+	bench.pushed_time = g_new0 (gint64, bench.total);
+	bench.handed_time = g_new0 (gint64, bench.total);
+
+	description = g_strdup_printf ("ueyesrc name=src num-buffers=%d %s ! %s%s fakesink name=sink sync=false signal-handoffs=true",
+			bench.total, props ? props : "", caps ? caps : "", caps ? " !" : "");
+	// a mistyped property is an error, not a warning the benchmark carries on past
+	pipeline = gst_parse_launch_full (description, NULL, GST_PARSE_FLAG_FATAL_ERRORS, &error);
+	g_free (description);
+	if (pipeline == NULL) {
+		g_printerr ("Could not make the pipeline: %s\n", error ? error->message : "unknown error");
+		g_clear_error (&error);
+		return 1;
+	}
+
+	src = gst_bin_get_by_name (GST_BIN (pipeline), "src");
+	sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+	pad = gst_element_get_static_pad (src, "src");
+	gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, src_probe, &bench, NULL);
+	gst_object_unref (pad);
+	g_signal_connect (sink, "handoff", G_CALLBACK (sink_handoff), &bench);
+
+	gst_element_set_state (pipeline, GST_STATE_PLAYING);
+	bus = gst_element_get_bus (pipeline);
+	msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+	if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+		gchar *debug;
+
+		gst_message_parse_error (msg, &error, &debug);
+		g_printerr ("Error from %s: %s\n%s\n", GST_OBJECT_NAME (msg->src), error->message, debug ? debug : "");
+		g_clear_error (&error);
+		g_free (debug);
+	}
+	else if (bench.handed < bench.total) {
+		g_printerr ("EOS after %d of %d frames\n", bench.handed, bench.total);
+	}
+	else {
+		ok = TRUE;
+	}
+	gst_message_unref (msg);
+	gst_object_unref (bus);
+	gst_element_set_state (pipeline, GST_STATE_NULL);
+
+	if (ok) {
+		// create() of frame i starts when the sink is done with frame i - 1
+		n = bench.total - warmup;
+		latency = g_new (gint64, n);
+		for (i = 0; i < n; i++)
+			latency[i] = bench.pushed_time[warmup + i] - bench.handed_time[warmup + i - 1];
+		qsort (latency, n, sizeof (gint64), compare_gint64);
+
+		elapsed = bench.handed_time[bench.total - 1] - bench.handed_time[warmup - 1];
+		g_print ("frames:          %d\n", n);
+		g_print ("sustained fps:   %.2f\n", n * (gdouble) G_USEC_PER_SEC / MAX (elapsed, 1));
+		g_print ("create() us:     p50 %" G_GINT64_FORMAT "  p90 %" G_GINT64_FORMAT "  p99 %" G_GINT64_FORMAT "  max %" G_GINT64_FORMAT "\n",
+				percentile (latency, n, 50), percentile (latency, n, 90), percentile (latency, n, 99), latency[n - 1]);
+		g_print ("cpu ms/frame:    %.3f\n", (bench.cpu_end - bench.cpu_start) / 1000.0 / n);
+		g_free (latency);
+	}
+
+	gst_object_unref (src);
+	gst_object_unref (sink);
+	gst_object_unref (pipeline);
+	g_free (bench.pushed_time);
+	g_free (bench.handed_time);
+
+	return ok ? 0 : 1;
+}